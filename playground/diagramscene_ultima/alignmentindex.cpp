@@ -0,0 +1,105 @@
+#include "alignmentindex.h"
+#include "diagramitem.h"
+
+#include <algorithm>
+
+void AlignmentIndex::clear()
+{
+    m_lefts.clear();
+    m_rights.clear();
+    m_tops.clear();
+    m_bottoms.clear();
+    m_centerXs.clear();
+    m_centerYs.clear();
+}
+
+void AlignmentIndex::rebuild(const QList<QGraphicsItem *> &items, QGraphicsItem *exclude)
+{
+    clear();
+    m_lefts.reserve(items.size());
+    m_rights.reserve(items.size());
+    m_tops.reserve(items.size());
+    m_bottoms.reserve(items.size());
+    m_centerXs.reserve(items.size());
+    m_centerYs.reserve(items.size());
+
+    for (QGraphicsItem *item : items) {
+        if (item == exclude)
+            continue;
+        DiagramItem *diagramItem = qgraphicsitem_cast<DiagramItem *>(item);
+        if (diagramItem == nullptr)
+            continue;
+        QRectF rect = diagramItem->sceneBoundingRect();
+        m_lefts.append({rect.left(), diagramItem});
+        m_rights.append({rect.right(), diagramItem});
+        m_tops.append({rect.top(), diagramItem});
+        m_bottoms.append({rect.bottom(), diagramItem});
+        m_centerXs.append({rect.center().x(), diagramItem});
+        m_centerYs.append({rect.center().y(), diagramItem});
+    }
+
+    const auto byValue = [](const Entry &a, const Entry &b) { return a.value < b.value; };
+    std::sort(m_lefts.begin(), m_lefts.end(), byValue);
+    std::sort(m_rights.begin(), m_rights.end(), byValue);
+    std::sort(m_tops.begin(), m_tops.end(), byValue);
+    std::sort(m_bottoms.begin(), m_bottoms.end(), byValue);
+    std::sort(m_centerXs.begin(), m_centerXs.end(), byValue);
+    std::sort(m_centerYs.begin(), m_centerYs.end(), byValue);
+}
+
+//二分查到第一个不小于value的条目 和左右邻居比谁更近
+bool AlignmentIndex::nearest(const QVector<Entry> &entries, qreal value,
+                             qreal tolerance, Match &match)
+{
+    if (entries.isEmpty())
+        return false;
+
+    const auto it = std::lower_bound(entries.begin(), entries.end(), value,
+                                     [](const Entry &entry, qreal v) { return entry.value < v; });
+
+    const Entry *best = nullptr;
+    if (it != entries.end())
+        best = &(*it);
+    if (it != entries.begin()) {
+        const Entry *prev = &(*(it - 1));
+        if (best == nullptr || qAbs(prev->value - value) < qAbs(best->value - value))
+            best = prev;
+    }
+
+    if (best == nullptr || qAbs(best->value - value) >= tolerance)
+        return false;
+
+    match.value = best->value;
+    match.item = best->item;
+    return true;
+}
+
+bool AlignmentIndex::nearestLeft(qreal value, qreal tolerance, Match &match) const
+{
+    return nearest(m_lefts, value, tolerance, match);
+}
+
+bool AlignmentIndex::nearestRight(qreal value, qreal tolerance, Match &match) const
+{
+    return nearest(m_rights, value, tolerance, match);
+}
+
+bool AlignmentIndex::nearestTop(qreal value, qreal tolerance, Match &match) const
+{
+    return nearest(m_tops, value, tolerance, match);
+}
+
+bool AlignmentIndex::nearestBottom(qreal value, qreal tolerance, Match &match) const
+{
+    return nearest(m_bottoms, value, tolerance, match);
+}
+
+bool AlignmentIndex::nearestCenterX(qreal value, qreal tolerance, Match &match) const
+{
+    return nearest(m_centerXs, value, tolerance, match);
+}
+
+bool AlignmentIndex::nearestCenterY(qreal value, qreal tolerance, Match &match) const
+{
+    return nearest(m_centerYs, value, tolerance, match);
+}
@@ -0,0 +1,49 @@
+#ifndef ALIGNMENTINDEX_H
+#define ALIGNMENTINDEX_H
+
+#include <QVector>
+#include <QList>
+#include <QGraphicsItem>
+
+class DiagramItem;
+
+//对齐吸附用的空间索引
+//拖动开始时把所有图元的六类边界坐标(左右上下和中心)各自排序存好
+//mouseMoveEvent里用二分查找找±tolerance内的候选 不再每次遍历整个场景
+class AlignmentIndex
+{
+public:
+    struct Entry {
+        qreal value;        //边界或中心的场景坐标
+        DiagramItem *item;
+    };
+
+    struct Match {
+        qreal value;
+        DiagramItem *item;
+    };
+
+    //重建索引 exclude是正在拖动的图元 自己不和自己对齐
+    void rebuild(const QList<QGraphicsItem *> &items, QGraphicsItem *exclude);
+    void clear();
+
+    bool nearestLeft(qreal value, qreal tolerance, Match &match) const;
+    bool nearestRight(qreal value, qreal tolerance, Match &match) const;
+    bool nearestTop(qreal value, qreal tolerance, Match &match) const;
+    bool nearestBottom(qreal value, qreal tolerance, Match &match) const;
+    bool nearestCenterX(qreal value, qreal tolerance, Match &match) const;
+    bool nearestCenterY(qreal value, qreal tolerance, Match &match) const;
+
+private:
+    static bool nearest(const QVector<Entry> &entries, qreal value,
+                        qreal tolerance, Match &match);
+
+    QVector<Entry> m_lefts;
+    QVector<Entry> m_rights;
+    QVector<Entry> m_tops;
+    QVector<Entry> m_bottoms;
+    QVector<Entry> m_centerXs;
+    QVector<Entry> m_centerYs;
+};
+
+#endif // ALIGNMENTINDEX_H
@@ -0,0 +1,59 @@
+#include "autosavemanager.h"
+#include "binaryprojectfile.h"
+
+#include <QMutexLocker>
+#include <QDebug>
+
+AutosaveManager::AutosaveManager()
+{
+    //自己搬到工作线程 writeRequested用队列连接 槽就在工作线程执行
+    moveToThread(&workerThread);
+    connect(this, &AutosaveManager::writeRequested,
+            this, &AutosaveManager::writePending, Qt::QueuedConnection);
+    workerThread.start();
+}
+
+AutosaveManager::~AutosaveManager()
+{
+    workerThread.quit();
+    workerThread.wait();
+}
+
+void AutosaveManager::submitSnapshot(const QString &filePath,
+                                     const QList<WriteDiagramItem> &items,
+                                     const QList<WriteDiagramPath> &paths)
+{
+    QMutexLocker locker(&mutex);
+    //永远只留最新一份 写盘慢的时候中间版本直接跳过
+    pendingPath = filePath;
+    pendingItems = items;
+    pendingPaths = paths;
+    hasPending = true;
+    if (!writing) {
+        writing = true;
+        emit writeRequested();
+    }
+}
+
+void AutosaveManager::writePending()
+{
+    //循环消化 写盘期间又来了新快照就接着写最新的
+    forever {
+        QString filePath;
+        QList<WriteDiagramItem> items;
+        QList<WriteDiagramPath> paths;
+        {
+            QMutexLocker locker(&mutex);
+            if (!hasPending) {
+                writing = false;
+                return;
+            }
+            filePath = pendingPath;
+            items = pendingItems;
+            paths = pendingPaths;
+            hasPending = false;
+        }
+        if (!BinaryProjectFile::save(filePath, items, paths))
+            qDebug() << "自动保存失败:" << filePath;
+    }
+}
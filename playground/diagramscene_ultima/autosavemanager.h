@@ -0,0 +1,44 @@
+#ifndef AUTOSAVEMANAGER_H
+#define AUTOSAVEMANAGER_H
+
+#include <QObject>
+#include <QThread>
+#include <QMutex>
+#include "projectrecords.h"
+
+//自动保存流水线
+//GUI线程只做一次值拷贝快照 序列化和写盘都在工作线程完成
+//编辑来得比写盘快时只保留最新一份快照 旧的直接作废(写合并)
+//对象构造后整体搬到工作线程上 所以不能给它设父对象
+class AutosaveManager : public QObject
+{
+    Q_OBJECT
+
+public:
+    AutosaveManager();
+    ~AutosaveManager();
+
+    //GUI线程调用 提交一份场景快照 立即返回不等待写盘
+    void submitSnapshot(const QString &filePath,
+                        const QList<WriteDiagramItem> &items,
+                        const QList<WriteDiagramPath> &paths);
+
+signals:
+    //内部信号 用队列连接把写盘任务投递到工作线程
+    void writeRequested();
+
+private slots:
+    void writePending();    //在工作线程里执行 循环消化最新快照
+
+private:
+    QThread workerThread;
+
+    QMutex mutex;           //保护下面的待写快照
+    bool hasPending = false;
+    bool writing = false;   //工作线程是否正在消化快照
+    QString pendingPath;
+    QList<WriteDiagramItem> pendingItems;
+    QList<WriteDiagramPath> pendingPaths;
+};
+
+#endif // AUTOSAVEMANAGER_H
@@ -0,0 +1,136 @@
+#include "batchexporter.h"
+
+#include "projectloader.h"
+#include "diagramscene.h"
+
+#include <QtConcurrent>
+#include <QImage>
+#include <QPainter>
+#include <QSvgGenerator>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QDebug>
+
+//场景四周留一圈空白 和导出的视觉习惯一致
+static const int ExportMargin = 20;
+
+int BatchExporter::run(const QStringList &args)
+{
+    QStringList inputs;
+    QString output;
+    QString format = "png";
+
+    //--export后面的位置参数都是输入文件 -o/--format带一个值
+    int i = args.indexOf("--export") + 1;
+    if (i <= 0) {
+        qWarning() << "batch export: missing --export";
+        return 2;
+    }
+    for (; i < args.size(); ++i) {
+        const QString &arg = args.at(i);
+        if (arg == "-o" || arg == "--output") {
+            if (i + 1 >= args.size()) {
+                qWarning() << "batch export:" << arg << "needs a value";
+                return 2;
+            }
+            output = args.at(++i);
+        } else if (arg == "--format") {
+            if (i + 1 >= args.size()) {
+                qWarning() << "batch export: --format needs a value";
+                return 2;
+            }
+            format = args.at(++i).toLower();
+        } else {
+            inputs.append(arg);
+        }
+    }
+    if (inputs.isEmpty()) {
+        qWarning() << "batch export: no input files";
+        return 2;
+    }
+    if (format != "png" && format != "jpg" && format != "svg") {
+        qWarning() << "batch export: unsupported format" << format;
+        return 2;
+    }
+
+    QList<Job> jobs;
+    if (inputs.size() == 1 && !output.isEmpty() && !QFileInfo(output).isDir()) {
+        //单文件指明了输出名 后缀说了算
+        const QString suffix = QFileInfo(output).suffix().toLower();
+        if (suffix == "png" || suffix == "jpg" || suffix == "svg")
+            format = suffix;
+        jobs.append({inputs.first(), output});
+    } else {
+        //多文件(或没指明输出) -o当目录用 文件名沿用输入名换后缀
+        QDir outDir(output.isEmpty() ? QStringLiteral(".") : output);
+        if (!output.isEmpty() && !outDir.exists() && !outDir.mkpath(".")) {
+            qWarning() << "batch export: cannot create output directory" << output;
+            return 2;
+        }
+        for (const QString &input : inputs)
+            jobs.append({input, outDir.filePath(QFileInfo(input).completeBaseName() + "." + format)});
+    }
+
+    //文件之间互相独立 每个job整个在一条工作线程上跑完
+    //场景/图元/连线都建在那条线程上 定长块池按线程隔离 不需要锁
+    const QList<bool> results = QtConcurrent::blockingMapped(jobs, &BatchExporter::exportOne);
+
+    int failed = 0;
+    for (bool ok : results) {
+        if (!ok)
+            ++failed;
+    }
+    qInfo() << "batch export:" << (results.size() - failed) << "of" << results.size() << "files exported";
+    return failed == 0 ? 0 : 1;
+}
+
+bool BatchExporter::exportOne(const Job &job)
+{
+    QList<ReadDiagramItem> readDiagramItems;
+    QList<ReadDiagramPath> readDiagramPaths;
+    if (!ProjectLoader::loadProject(job.inputFile, readDiagramItems, readDiagramPaths)) {
+        qWarning() << "batch export: failed to load" << job.inputFile;
+        return false;
+    }
+
+    //无头模式没有右键菜单 场景只在本线程里用 渲染完就地销毁
+    DiagramScene scene(nullptr);
+    ProjectLoader::populateScene(&scene, nullptr, readDiagramItems, readDiagramPaths);
+
+    QRectF sourceRect = scene.itemsBoundingRect()
+                            .adjusted(-ExportMargin, -ExportMargin, ExportMargin, ExportMargin);
+    if (sourceRect.isEmpty())
+        sourceRect = QRectF(0, 0, 800, 600);    //空工程也给一张空白图
+    const QSize targetSize = sourceRect.size().toSize();
+
+    if (job.outputFile.endsWith(".svg", Qt::CaseInsensitive)) {
+        //SVG是矢量直写 不需要条带化
+        QSvgGenerator svgGen;
+        svgGen.setFileName(job.outputFile);
+        svgGen.setSize(targetSize);
+        svgGen.setViewBox(QRect(QPoint(0, 0), targetSize));
+
+        QPainter painter;
+        if (!painter.begin(&svgGen)) {
+            qWarning() << "batch export: cannot write" << job.outputFile;
+            return false;
+        }
+        scene.render(&painter, QRectF(QPointF(0, 0), sourceRect.size()), sourceRect);
+        painter.end();
+        return QFile::exists(job.outputFile);
+    }
+
+    QImage image(targetSize, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::white);
+    QPainter painter(&image);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setRenderHint(QPainter::TextAntialiasing);
+    scene.render(&painter, QRectF(QPointF(0, 0), sourceRect.size()), sourceRect);
+    painter.end();
+    if (!image.save(job.outputFile)) {
+        qWarning() << "batch export: cannot write" << job.outputFile;
+        return false;
+    }
+    return true;
+}
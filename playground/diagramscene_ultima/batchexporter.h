@@ -0,0 +1,28 @@
+#ifndef BATCHEXPORTER_H
+#define BATCHEXPORTER_H
+
+#include <QString>
+#include <QStringList>
+
+//无头批量导出
+//不建MainWindow 每个工程文件在工作线程里重建场景后离屏渲染成png/jpg/svg
+//文件之间互相独立 交给QtConcurrent按核数并行 CI/夜间归档转换用
+//
+//用法: diagramscene --export in1.fcproj [in2.fcproj ...] [-o 输出文件或目录] [--format png|jpg|svg]
+//单个输入且-o带后缀时按后缀定格式 多个输入时-o是输出目录 文件名沿用输入名换后缀
+class BatchExporter
+{
+public:
+    //跑完整个导出批次 返回进程退出码 0=全部成功 1=有文件失败 2=参数错误
+    static int run(const QStringList &args);
+
+private:
+    struct Job {
+        QString inputFile;
+        QString outputFile;
+    };
+
+    static bool exportOne(const Job &job);
+};
+
+#endif // BATCHEXPORTER_H
@@ -0,0 +1,253 @@
+#include "binaryprojectfile.h"
+#include "diagramitem.h"
+
+#include <QFile>
+#include <QHash>
+#include <QDebug>
+#include <cstring>
+
+//字符串表写入时去重 相同的字体名只存一份
+namespace {
+quint32 internString(const QString &str, QStringList &table, QHash<QString, quint32> &lookup)
+{
+    auto it = lookup.constFind(str);
+    if (it != lookup.constEnd())
+        return it.value();
+    quint32 id = table.size();
+    table.append(str);
+    lookup.insert(str, id);
+    return id;
+}
+
+//连线锚位必须是四个连接点之一 重建场景时锚位直接索引定长槽位数组
+bool validLinkAnchor(qint32 anchor)
+{
+    return anchor == DiagramItem::TF_Top || anchor == DiagramItem::TF_Right
+        || anchor == DiagramItem::TF_Bottom || anchor == DiagramItem::TF_Left;
+}
+}
+
+bool BinaryProjectFile::isBinary(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+    quint32 magic = 0;
+    if (file.read(reinterpret_cast<char *>(&magic), sizeof(magic)) != sizeof(magic))
+        return false;
+    return magic == Magic;
+}
+
+bool BinaryProjectFile::save(const QString &fileName,
+                             const QList<WriteDiagramItem *> &items,
+                             const QList<WriteDiagramPath *> &paths)
+{
+    //指针列表转成值列表后走同一套写盘逻辑
+    QList<WriteDiagramItem> itemValues;
+    itemValues.reserve(items.size());
+    for (WriteDiagramItem *itemPtr : items)
+        itemValues.append(*itemPtr);
+    QList<WriteDiagramPath> pathValues;
+    pathValues.reserve(paths.size());
+    for (WriteDiagramPath *pathPtr : paths) {
+        if (pathPtr)
+            pathValues.append(*pathPtr);
+    }
+    return save(fileName, itemValues, pathValues);
+}
+
+bool BinaryProjectFile::save(const QString &fileName,
+                             const QList<WriteDiagramItem> &items,
+                             const QList<WriteDiagramPath> &paths)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+    const QByteArray data = serialize(items, paths);
+    const bool ok = file.write(data) == data.size();
+    file.close();
+    return ok;
+}
+
+QByteArray BinaryProjectFile::serialize(const QList<WriteDiagramItem> &items,
+                                        const QList<WriteDiagramPath> &paths)
+{
+    QStringList stringTable;
+    QHash<QString, quint32> stringLookup;
+
+    //先生成定长记录区 字符串替换成表索引
+    QByteArray records;
+    records.reserve(items.size() * sizeof(ItemRecord) + paths.size() * sizeof(PathRecord));
+    for (const WriteDiagramItem &item : items) {
+        ItemRecord record;
+        std::memset(&record, 0, sizeof(record));
+        record.x = item.x;
+        record.y = item.y;
+        record.width = item.width;
+        record.height = item.height;
+        record.type = item.type;
+        for (int i = 0; i < 4; ++i) {
+            record.rbg[i] = item.rbg[i];
+            record.textrbg[i] = item.textrbg[i];
+        }
+        record.itemtype = item.itemtype;
+        record.textsize = item.textsize;
+        record.boldtype = item.boldtype ? 1 : 0;
+        record.itlatic = item.itlatic ? 1 : 0;
+        record.internalTextId = internString(item.internalText, stringTable, stringLookup);
+        record.texttypeId = internString(item.texttype, stringTable, stringLookup);
+        records.append(reinterpret_cast<const char *>(&record), sizeof(record));
+    }
+    for (const WriteDiagramPath &path : paths) {
+        PathRecord record;
+        record.start = path.start;
+        record.startp = path.startp;
+        record.end = path.end;
+        record.endp = path.endp;
+        records.append(reinterpret_cast<const char *>(&record), sizeof(record));
+    }
+
+    Header header;
+    header.magic = Magic;
+    header.version = Version;
+    header.itemCount = items.size();
+    header.pathCount = paths.size();
+    header.stringTableOffset = sizeof(Header) + records.size();
+    header.reserved = 0;
+
+    QByteArray out;
+    out.reserve(sizeof(Header) + records.size());
+    out.append(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.append(records);
+
+    //字符串表: 条目数 + 每条[字节长度+UTF-8内容]
+    quint32 count = stringTable.size();
+    out.append(reinterpret_cast<const char *>(&count), sizeof(count));
+    for (const QString &str : std::as_const(stringTable)) {
+        QByteArray utf8 = str.toUtf8();
+        quint32 len = utf8.size();
+        out.append(reinterpret_cast<const char *>(&len), sizeof(len));
+        out.append(utf8);
+    }
+    return out;
+}
+
+bool BinaryProjectFile::load(const QString &fileName,
+                             QList<ReadDiagramItem> &items,
+                             QList<ReadDiagramPath> &paths)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    //整个文件映射进地址空间 记录区零拷贝读取
+    uchar *data = file.map(0, file.size());
+    if (!data) {
+        qDebug() << "map failed, fall back to normal read";
+        return false;
+    }
+    const bool ok = parse(data, file.size(), items, paths);
+    file.unmap(data);
+    return ok;
+}
+
+bool BinaryProjectFile::deserialize(const QByteArray &data,
+                                    QList<ReadDiagramItem> &items,
+                                    QList<ReadDiagramPath> &paths)
+{
+    return parse(reinterpret_cast<const uchar *>(data.constData()), data.size(), items, paths);
+}
+
+bool BinaryProjectFile::parse(const uchar *data, qint64 size,
+                              QList<ReadDiagramItem> &items,
+                              QList<ReadDiagramPath> &paths)
+{
+    const qint64 fileSize = size;
+    if (fileSize < qint64(sizeof(Header)))
+        return false;
+
+    Header header;
+    std::memcpy(&header, data, sizeof(header));
+    if (header.magic != Magic || header.version > Version)
+        return false;
+
+    const qint64 recordsEnd = sizeof(Header)
+            + qint64(header.itemCount) * sizeof(ItemRecord)
+            + qint64(header.pathCount) * sizeof(PathRecord);
+    if (recordsEnd > fileSize || header.stringTableOffset != recordsEnd)
+        return false;
+
+    //先读字符串表 item记录靠索引取文本
+    QStringList stringTable;
+    {
+        const uchar *p = data + header.stringTableOffset;
+        const uchar *end = data + fileSize;
+        if (p + sizeof(quint32) > end)
+            return false;
+        quint32 count;
+        std::memcpy(&count, p, sizeof(count));
+        p += sizeof(count);
+        stringTable.reserve(count);
+        for (quint32 i = 0; i < count; ++i) {
+            if (p + sizeof(quint32) > end)
+                return false;
+            quint32 len;
+            std::memcpy(&len, p, sizeof(len));
+            p += sizeof(len);
+            if (p + len > end)
+                return false;
+            stringTable.append(QString::fromUtf8(reinterpret_cast<const char *>(p), len));
+            p += len;
+        }
+    }
+
+    items.reserve(header.itemCount);
+    const uchar *p = data + sizeof(Header);
+    for (quint32 i = 0; i < header.itemCount; ++i) {
+        ItemRecord record;
+        std::memcpy(&record, p, sizeof(record));
+        p += sizeof(record);
+
+        ReadDiagramItem item;
+        item.x = record.x;
+        item.y = record.y;
+        item.width = record.width;
+        item.height = record.height;
+        item.type = record.type;
+        for (int j = 0; j < 4; ++j) {
+            item.rbg[j] = record.rbg[j];
+            item.textrbg[j] = record.textrbg[j];
+        }
+        item.itemtype = record.itemtype;
+        item.textsize = record.textsize;
+        item.boldtype = record.boldtype != 0;
+        item.itlatic = record.itlatic != 0;
+        if (record.internalTextId < quint32(stringTable.size()))
+            item.internalText = stringTable.at(record.internalTextId);
+        if (record.texttypeId < quint32(stringTable.size()))
+            item.texttype = stringTable.at(record.texttypeId);
+        items.append(item);
+    }
+
+    paths.reserve(header.pathCount);
+    for (quint32 i = 0; i < header.pathCount; ++i) {
+        PathRecord record;
+        std::memcpy(&record, p, sizeof(record));
+        p += sizeof(record);
+
+        ReadDiagramPath path;
+        path.start = record.start;
+        path.startp = record.startp;
+        path.end = record.end;
+        path.endp = record.endp;
+        //记录值也要验证 端点编号是1起的item下标 锚位直接当数组下标用
+        //损坏或恶意构造的文件在这里拒收 不带越界值进populateScene
+        if (path.start < 1 || quint32(path.start) > header.itemCount
+                || path.end < 1 || quint32(path.end) > header.itemCount
+                || !validLinkAnchor(path.startp) || !validLinkAnchor(path.endp))
+            return false;
+        paths.append(path);
+    }
+
+    return true;
+}
@@ -0,0 +1,85 @@
+#ifndef BINARYPROJECTFILE_H
+#define BINARYPROJECTFILE_H
+
+#include <QString>
+#include <QList>
+#include "projectrecords.h"
+
+//二进制 .fcproj 格式读写
+//布局: [文件头][定长item记录区][定长path记录区][字符串表]
+//数值字段按定长记录连续存放 可以直接在 QFile::map() 的内存上读取
+//文本和字体名统一放到尾部的字符串表 记录里只存索引
+class BinaryProjectFile
+{
+public:
+    //文件头 所有整型字段按小端存储
+    struct Header {
+        quint32 magic;      //'FCPB'
+        quint32 version;    //格式版本号 当前为1
+        quint32 itemCount;
+        quint32 pathCount;
+        quint32 stringTableOffset;  //字符串表相对文件头的字节偏移
+        quint32 reserved;
+    };
+
+    //定长item记录 对应WriteDiagramItem的数值字段
+    struct ItemRecord {
+        qint32 x;
+        qint32 y;
+        qint32 width;
+        qint32 height;
+        qint32 type;
+        qint32 rbg[4];
+        qint32 itemtype;
+        qint32 textsize;
+        quint8 boldtype;
+        quint8 itlatic;
+        quint8 pad[2];
+        qint32 textrbg[4];
+        quint32 internalTextId; //字符串表索引
+        quint32 texttypeId;     //字符串表索引
+    };
+
+    //定长path记录
+    struct PathRecord {
+        qint32 start;
+        qint32 startp;
+        qint32 end;
+        qint32 endp;
+    };
+
+    static const quint32 Magic = 0x42504346; // 'FCPB' 小端
+    static const quint32 Version = 1;
+
+    //判断文件是不是二进制格式 用于加载时选择旧文本格式的回退读取
+    static bool isBinary(const QString &fileName);
+
+    static bool save(const QString &fileName,
+                     const QList<WriteDiagramItem *> &items,
+                     const QList<WriteDiagramPath *> &paths);
+
+    //值列表版本 自动保存用 快照整体值拷贝后在工作线程写盘
+    static bool save(const QString &fileName,
+                     const QList<WriteDiagramItem> &items,
+                     const QList<WriteDiagramPath> &paths);
+
+    //通过QFile::map映射后直接按记录读取 只有字符串需要构造
+    static bool load(const QString &fileName,
+                     QList<ReadDiagramItem> &items,
+                     QList<ReadDiagramPath> &paths);
+
+    //序列化到内存 字节布局和文件完全一致 历史环等内存快照场景用
+    static QByteArray serialize(const QList<WriteDiagramItem> &items,
+                                const QList<WriteDiagramPath> &paths);
+    static bool deserialize(const QByteArray &data,
+                            QList<ReadDiagramItem> &items,
+                            QList<ReadDiagramPath> &paths);
+
+private:
+    //文件映射和内存字节走同一套记录解析
+    static bool parse(const uchar *data, qint64 size,
+                      QList<ReadDiagramItem> &items,
+                      QList<ReadDiagramPath> &paths);
+};
+
+#endif // BINARYPROJECTFILE_H
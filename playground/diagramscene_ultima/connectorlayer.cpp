@@ -0,0 +1,94 @@
+#include "connectorlayer.h"
+#include "diagrampath.h"
+#include "diagramscene.h"
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+
+ConnectorLayer::ConnectorLayer(QGraphicsItem *parent)
+    : QGraphicsItem(parent)
+{
+    setAcceptedMouseButtons(Qt::NoButton);
+}
+
+ConnectorLayer::~ConnectorLayer()
+{
+    //scene->clear()会把本层当普通图元删掉 通知场景放弃缓存的指针
+    if (DiagramScene *diagramScene = qobject_cast<DiagramScene *>(scene()))
+        diagramScene->connectorLayerDestroyed(this);
+}
+
+QRectF ConnectorLayer::boundingRect() const
+{
+    return bounds;
+}
+
+QPainterPath ConnectorLayer::shape() const
+{
+    //空形状 命中测试全部留给单条DiagramPath
+    return QPainterPath();
+}
+
+void ConnectorLayer::paint(QPainter *painter, const QStyleOptionGraphicsItem *option,
+                           QWidget *)
+{
+    painter->setRenderHint(QPainter::Antialiasing);
+    const QRectF exposed = option->exposedRect;
+
+    QPen currentPen;
+    bool penSet = false;
+    for (DiagramPath *path : std::as_const(connectorList)) {
+        if (!path->isVisible())
+            continue;
+        const QPainterPath &geometry = path->path();
+        //只画和曝光区相交的连线 视口外的整条跳过
+        if (!exposed.intersects(geometry.boundingRect()))
+            continue;
+
+        QPen pen = path->pen();
+        if (path->isSelected()) {
+            pen.setColor(Qt::blue);
+            pen.setStyle(Qt::DashLine);
+        }
+        //颜色/样式相同的连线共用画笔 不反复切状态
+        if (!penSet || pen != currentPen) {
+            painter->setPen(pen);
+            currentPen = pen;
+            penSet = true;
+        }
+        painter->drawPath(geometry);
+    }
+}
+
+void ConnectorLayer::registerPath(DiagramPath *path)
+{
+    if (!connectorList.contains(path))
+        connectorList.append(path);
+    geometryChanged();
+}
+
+void ConnectorLayer::unregisterPath(DiagramPath *path)
+{
+    connectorList.removeOne(path);
+    geometryChanged();
+}
+
+void ConnectorLayer::pathUpdated(DiagramPath *path)
+{
+    //只向外扩包围盒 真正收缩留给geometryChanged统一算 避免每条连线都扫全表
+    const QRectF rect = path->path().boundingRect();
+    if (!bounds.contains(rect)) {
+        prepareGeometryChange();
+        bounds = bounds.united(rect);
+    }
+    update();
+}
+
+void ConnectorLayer::geometryChanged()
+{
+    prepareGeometryChange();
+    QRectF united;
+    for (DiagramPath *path : std::as_const(connectorList))
+        united = united.united(path->path().boundingRect());
+    bounds = united;
+    update();
+}
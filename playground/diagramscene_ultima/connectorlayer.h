@@ -0,0 +1,37 @@
+#ifndef CONNECTORLAYER_H
+#define CONNECTORLAYER_H
+
+#include <QGraphicsItem>
+#include <QVector>
+
+class DiagramPath;
+
+//聚合连线层
+//批量模式下所有DiagramPath把几何登记到这里 由本图元一遍画完
+//画笔状态只在颜色变化时切换 单条连线不再各自经历save/restore
+//各DiagramPath仍留在场景里承担命中测试和选中 本层自身不参与命中
+class ConnectorLayer : public QGraphicsItem
+{
+public:
+    enum { Type = UserType + 21 };
+
+    explicit ConnectorLayer(QGraphicsItem *parent = nullptr);
+    ~ConnectorLayer() override;
+
+    int type() const override { return Type; }
+    QRectF boundingRect() const override;
+    QPainterPath shape() const override;    //返回空路径 点击永远穿透到下面的连线
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option,
+               QWidget *widget) override;
+
+    void registerPath(DiagramPath *path);
+    void unregisterPath(DiagramPath *path);
+    void geometryChanged();     //连线批量重算后刷新包围盒并请求重绘
+    void pathUpdated(DiagramPath *path);    //单条重算后的增量刷新 包围盒只增不减
+
+private:
+    QVector<DiagramPath *> connectorList;   //连续数组 绘制时顺序扫描
+    QRectF bounds;
+};
+
+#endif // CONNECTORLAYER_H
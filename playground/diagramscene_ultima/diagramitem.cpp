@@ -7,9 +7,44 @@
 #include <QGraphicsSceneContextMenuEvent>
 #include <QMenu>
 #include <QPainter>
+#include <QStyleOptionGraphicsItem>
 #include "diagramtextitem.h"
 #include "diagrampath.h"
 #include "diagramscene.h"
+#include "perftrace.h"
+
+#include "objectpool.h"
+
+//LOD阈值 低于下限整个图元退化成平色矩形 低于上限用缓存路径但关掉抗锯齿
+static const qreal itemLodFlatThreshold = 0.2;
+static const qreal itemLodDetailThreshold = 0.6;
+
+//每个线程一个定长块池 GUI线程不加锁 无头导出各工作线程互不干扰
+//图元在哪条线程上建就在哪条线程上删 块不跨线程
+static FixedBlockPool &itemPool()
+{
+    static thread_local FixedBlockPool pool(sizeof(DiagramItem));
+    return pool;
+}
+
+void *DiagramItem::operator new(std::size_t size)
+{
+    //派生类尺寸不同 走普通堆
+    if (size != sizeof(DiagramItem))
+        return ::operator new(size);
+    return itemPool().allocate();
+}
+
+void DiagramItem::operator delete(void *block, std::size_t size)
+{
+    if (block == nullptr)
+        return;
+    if (size != sizeof(DiagramItem)) {
+        ::operator delete(block);
+        return;
+    }
+    itemPool().deallocate(block);
+}
 
 
 DiagramItem::DiagramItem(DiagramType diagramType, QMenu *contextMenu, QGraphicsItem *parent)
@@ -28,23 +63,17 @@ DiagramItem::DiagramItem(DiagramType diagramType, QMenu *contextMenu, QGraphicsI
              QGraphicsItem::ItemIsMovable);
     setAcceptHoverEvents(true);
 
-    textItem = new DiagramTextItem(this);
-    textItem->setPlainText("请输入");  // 设置初始文本
-    textItem->setTextInteractionFlags(Qt::TextEditorInteraction);  // 允许文本编辑
-    textItem->setPos(boundingRect().center() - QPointF(textItem->boundingRect().width() / 2, textItem->boundingRect().height() / 2));
+    //标签模式 构造时只留textContent里的字符串 不建文本框不做富文本排版
+    //双击开始编辑时promoteLabel()才创建真正的DiagramTextItem
+    textItem = nullptr;
 }
 
 QRectF DiagramItem::boundingRect() const
 {
-
-    QRectF rect(QPointF(-20,-20),m_grapSize+QSize(40,40));
-    // QRectF rect(QPointF(0, 0), m_grapSize);
-
-    // 使用当前旋转角度计算旋转后的边界框
-    QTransform transform;
-    transform.rotate(m_rotationAngle);
-
-    return transform.mapRect(rect).normalized();
+    //包围盒走几何缓存 脏了才重算
+    if (m_geomDirty)
+        const_cast<DiagramItem *>(this)->rebuildGeometry();
+    return m_boundingRect;
 }
 
 void DiagramItem::setBrush(QColor &color){
@@ -54,30 +83,21 @@ void DiagramItem::setBrush(QColor &color){
 
 void DiagramItem::setFixedSize(const QSizeF &size) {
     m_grapSize = size;
-    prepareGeometryChange();
+    markGeometryDirty();
     update();
 }
 
 
-void DiagramItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option,
-                        QWidget *){
-
-    painter->setRenderHint(QPainter::Antialiasing);
-
-    // 保存当前的绘制状态
-    painter->save();
-
-    // 旋转图元，根据当前的旋转角度
-    painter->rotate(m_rotationAngle);
-    ///////////////////////////////////////////////////////////////////////////
+//几何缓存重建 只有脏标记置位时才执行
+//把原来paint()里每帧重建QPainterPath的大switch挪到这里 绘制时直接用缓存
+void DiagramItem::rebuildGeometry()
+{
     qreal  w = m_grapSize.width();
     qreal  h = m_grapSize.height();
     qreal  b = m_border;
 
     QPainterPath path;
 
-    painter->setBrush(m_color);
-
     switch (myDiagramType) {
     case StartEnd:
         path.moveTo(b+(w-2*b)*0.15, b);
@@ -86,7 +106,6 @@ void DiagramItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *optio
         path.arcTo(QRectF(w-b-(w-2*b)*0.3,b,(w-2*b)*0.3,h-2*b),270,180);
         path.closeSubpath();
 
-        painter->drawPath(path);
         break;
 
     case Conditional:
@@ -94,17 +113,15 @@ void DiagramItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *optio
         myPolygon << QPointF(w/2, m_border) << QPointF(m_border,h/2)
                   << QPointF(w/2, h-m_border) << QPointF(w-m_border, h/2)
                   << QPointF(w/2, m_border);
-        painter->drawPolygon(myPolygon);
+        path.addPolygon(myPolygon);
         break;
     case Step:
         path.addRect(QRectF(QPointF(m_border,m_border),m_grapSize-QSizeF(10,10) ) ); //根据给定尺寸绘制图形
         myPolygon = path.toFillPolygon();
-        painter->drawPolygon(myPolygon);
         break;
     case circular:
         path.addEllipse(m_border,m_border,w-2*m_border,h-2*m_border);
         myPolygon = path.toFillPolygon();
-        painter->drawPolygon(myPolygon);
         break;
     case Document:{
         // m_grapSize.setWidth(m_grapSize.height() * 1.5);
@@ -130,7 +147,6 @@ void DiagramItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *optio
                      bottomRight.x(), bottomRight.y());
 
         // 绘制矩形的路径
-        painter->drawPath(path);
         break;
     }
     case PredefinedProcess:{
@@ -156,7 +172,6 @@ void DiagramItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *optio
         path.lineTo(rightLineBottom);
 
         // 绘制矩形和内侧线条
-        painter->drawPath(path);
         break;
     }
 
@@ -172,7 +187,6 @@ void DiagramItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *optio
         // path.lineTo(w-b-(w-2*b)*0.15,b);
         // path.closeSubpath();
 
-        painter->drawPath(path);
         break;
     }
     case Memory: {
@@ -194,7 +208,6 @@ void DiagramItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *optio
         path.lineTo(QPointF(m_border + lineHeight, m_grapSize.height() - m_border));
 
         // 完成绘制
-        painter->drawPath(path);
         break;
     }
     case SequentialAccessStorage: {
@@ -216,7 +229,6 @@ void DiagramItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *optio
         path.lineTo(QPointF(m_grapSize.width() - b, m_grapSize.height() - b));
 
         // 绘制路径
-        painter->drawPath(path);
         break;
     }
     case Io:
@@ -224,7 +236,7 @@ void DiagramItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *optio
         myPolygon << QPointF(b+(w-2*b)*0.2, b) << QPointF(w-b,b)
                   << QPointF(w-b-(w-2*b)*0.2, h-b) << QPointF(b, h-b)
                   << QPointF(b+(w-2*b)*0.2,b);
-        painter->drawPolygon(myPolygon);
+        path.addPolygon(myPolygon);
         break;
 
     case DirectAccessStorage: {   //多一条竖线
@@ -249,7 +261,6 @@ void DiagramItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *optio
         path.arcTo(QRectF(m_grapSize.width() - diameter, b, diameter, diameter), 270, 180);
         path.closeSubpath();
         // 绘制路径
-        painter->drawPath(path);
         break;
     }
     case Disk: {
@@ -277,7 +288,6 @@ void DiagramItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *optio
 
         // 绘制路径
         // path.closeSubpath();
-        painter->drawPath(path);
         break;
     }
     case Card: {
@@ -302,7 +312,6 @@ void DiagramItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *optio
         path.lineTo(b, h - b);
 
         // 绘制路径
-        painter->drawPath(path);
         break;
     }
     case ManualInput:{
@@ -324,7 +333,6 @@ void DiagramItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *optio
         path.lineTo(b, h - b);
 
         // 绘制路径
-        painter->drawPath(path);
         break;
     }
     case PerforatedTape:{    //填充有问题
@@ -360,7 +368,6 @@ void DiagramItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *optio
                      topLeft.x(), topLeft.y());
 
         // 绘制路径
-        painter->drawPath(path);
         break;
     }
     case Display:{
@@ -383,7 +390,6 @@ void DiagramItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *optio
 
         // 关闭路径
         path.closeSubpath();
-        painter->drawPath(path);
         break;
     }
     case Preparation: {
@@ -411,7 +417,6 @@ void DiagramItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *optio
         path.closeSubpath();
 
         // 绘制路径
-        painter->drawPath(path);
         break;
     }
     case  ManualOperation: {
@@ -432,7 +437,6 @@ void DiagramItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *optio
         path.closeSubpath();
 
         // 绘制路径
-        painter->drawPath(path);
         break;
     }
     case ParallelMode: {
@@ -450,7 +454,6 @@ void DiagramItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *optio
         path.lineTo(w - b, 2 * h / 3);
 
         // 绘制路径
-        painter->drawPath(path);
         break;
     }
     case Hexagon: {
@@ -473,7 +476,6 @@ void DiagramItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *optio
         path.closeSubpath();
 
         // 绘制路径
-        painter->drawPath(path);
         break;
     }
 
@@ -481,12 +483,127 @@ void DiagramItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *optio
         qDebug()<<"this Node does not exist!";
     }
 
+    m_shapePath = path;
+
+    //包围盒同样缓存 旋转角度也在这里算好
+    QRectF rect(QPointF(-20,-20),m_grapSize+QSize(40,40));
+    QTransform transform;
+    transform.rotate(m_rotationAngle);
+    m_boundingRect = transform.mapRect(rect).normalized();
+
+    m_geomDirty = false;
+}
+
+void DiagramItem::markGeometryDirty()
+{
+    prepareGeometryChange();
+    m_geomDirty = true;
+    m_handlesDirty = true;
+}
+
+const DiagramItem::TransformState DiagramItem::HandleStates[8] = {
+    TF_TopL, TF_Top, TF_TopR, TF_Right, TF_BottomR, TF_Bottom, TF_BottomL, TF_Left};
+const DiagramItem::TransformState DiagramItem::LinkStates[4] = {
+    TF_Top, TF_Right, TF_Bottom, TF_Left};
+
+//控制点和锚点的矩形只和尺寸有关 算一次存进定长数组
+//悬停检测和连线重算每帧都要查 不能每次都建QMap
+void DiagramItem::rebuildHandles()
+{
+    int x1 = 0;
+    int x2 = m_grapSize.width() / 2 - m_border;
+    int x3 = m_grapSize.width() - m_border * 2;
+    int y1 = 0;
+    int y2 = m_grapSize.height() / 2 - m_border;
+    int y3 = m_grapSize.height() - m_border * 2;
+    qreal borderWH = m_border * 2 / transform().m11();
+
+    m_handleRects[TF_TopL] = QRectF(x1, y1, borderWH, borderWH);
+    m_handleRects[TF_Top] = QRectF(x2, y1, borderWH, borderWH);
+    m_handleRects[TF_TopR] = QRectF(x3, y1, borderWH, borderWH);
+    m_handleRects[TF_Right] = QRectF(x3, y2, borderWH, borderWH);
+    m_handleRects[TF_BottomR] = QRectF(x3, y3, borderWH, borderWH);
+    m_handleRects[TF_Bottom] = QRectF(x2, y3, borderWH, borderWH);
+    m_handleRects[TF_BottomL] = QRectF(x1, y3, borderWH, borderWH);
+    m_handleRects[TF_Left] = QRectF(x1, y2, borderWH, borderWH);
+
+    //锚点比控制点向外偏15
+    m_linkRects[TF_Top] = QRectF(x2, y1 - 15, borderWH, borderWH);
+    m_linkRects[TF_Right] = QRectF(x3 + 15, y2, borderWH, borderWH);
+    m_linkRects[TF_Left] = QRectF(x1 - 15, y2, borderWH, borderWH);
+    m_linkRects[TF_Bottom] = QRectF(x2, y3 + 15, borderWH, borderWH);
+
+    m_handlesDirty = false;
+}
+
+const QRectF &DiagramItem::handleRect(TransformState state)
+{
+    if (m_handlesDirty)
+        rebuildHandles();
+    return m_handleRects[state];
+}
+
+const QRectF &DiagramItem::linkRect(TransformState state)
+{
+    if (m_handlesDirty)
+        rebuildHandles();
+    return m_linkRects[state];
+}
+
+void DiagramItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option,
+                        QWidget *){
+
+    //HUD统计每帧画了多少图元 开关关着时只剩一次bool判断
+    if (PerfTrace::enabled)
+        PerfTrace::instance().addCount("paint.items", 1);
+
+    //几何变过才重建 正常重绘直接用缓存的路径
+    if (m_geomDirty)
+        rebuildGeometry();
+
+    //按当前缩放比例分级绘制 俯瞰全图时不值得画细节
+    const qreal lod = option->levelOfDetailFromTransform(painter->worldTransform());
+    if (lod < itemLodFlatThreshold) {
+        //一个图元在屏幕上只剩几个像素 画个平色块就够了
+        painter->fillRect(QRectF(QPointF(m_border, m_border), m_grapSize - QSizeF(10, 10)),
+                          m_color);
+        return;
+    }
+
+    //中等缩放用缓存路径但关掉抗锯齿 够近了才开
+    painter->setRenderHint(QPainter::Antialiasing, lod >= itemLodDetailThreshold);
+
+    // 保存当前的绘制状态
+    painter->save();
+
+    // 旋转图元，根据当前的旋转角度
+    painter->rotate(m_rotationAngle);
+
+    painter->setBrush(m_color);
+    painter->drawPath(m_shapePath);
+
     // 仅更新文本框的位置，不旋转文本框
-    textItem->setPos(boundingRect().center() - QPointF(textItem->boundingRect().width() / 2, textItem->boundingRect().height() / 2));
+    if (textItem != nullptr)
+        textItem->setPos(boundingRect().center() - QPointF(textItem->boundingRect().width() / 2, textItem->boundingRect().height() / 2));
 
     // 恢复绘制状态
     painter->restore();
 
+    //标签模式直接画缓存排版好的静态文本 居中且不随图元旋转
+    if (textItem == nullptr && !textContent.isEmpty()) {
+        if (m_labelDirty) {
+            m_labelStatic.setText(textContent);
+            m_labelStatic.prepare(QTransform(), m_labelFont);
+            m_labelDirty = false;
+        }
+        painter->setFont(m_labelFont);
+        painter->setPen(m_labelColor);
+        const QSizeF textSize = m_labelStatic.size();
+        painter->drawStaticText(boundingRect().center()
+                                - QPointF(textSize.width() / 2, textSize.height() / 2),
+                                m_labelStatic);
+    }
+
     qreal penW = 1.0 / painter->transform().m11();
     QRectF imgRect =
         QRectF(QPointF(m_border, m_border), m_grapSize - QSizeF(10, 10));
@@ -511,15 +628,13 @@ void DiagramItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *optio
         // 绘出8个角的控制点
         painter->setPen(PointPen);
 
-        const QMap<TransformState, QRectF> rectMap = rectWhere();
-        const QMap<TransformState,QRectF> linkMap = linkWhere();
         painter->setBrush(QBrush(Qt::red));
-        for (const TransformState state : rectMap.keys()) {
-            painter->drawRect(rectMap[state]);
+        for (const TransformState state : HandleStates) {
+            painter->drawRect(handleRect(state));
         }
         painter->setBrush(QBrush(Qt::blue));
-        for(QRectF link : linkMap){
-            painter->drawRect(link);
+        for(const TransformState state : LinkStates){
+            painter->drawRect(linkRect(state));
         }
 
         // 恢复画笔状态
@@ -527,10 +642,9 @@ void DiagramItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *optio
     }
 
     if(showLink){
-        const QMap<TransformState,QRectF> linkMap = linkWhere();
         painter->setBrush(QBrush(Qt::blue));
-        for(QRectF link : linkMap){
-            painter->drawRect(link);
+        for(const TransformState state : LinkStates){
+            painter->drawRect(linkRect(state));
         }
     }
 
@@ -545,9 +659,8 @@ void DiagramItem::hoverMoveEvent(QGraphicsSceneHoverEvent *event) {
 
     bool isHit = false;
     if(QRectF(QPointF(0,0),m_grapSize).contains(event->pos() ) ){
-        const QMap<TransformState, QRectF> rectMap = rectWhere();
-        for (const TransformState tsf : rectMap.keys()) {
-            if (rectMap[tsf].contains(event->pos())) {
+        for (const TransformState tsf : HandleStates) {
+            if (handleRect(tsf).contains(event->pos())) {
                 switch (tsf) {
                 case TF_Top:
                 case TF_Bottom: {
@@ -575,9 +688,8 @@ void DiagramItem::hoverMoveEvent(QGraphicsSceneHoverEvent *event) {
         }
     }
     else{
-        const QMap<TransformState,QRectF> linkMap = linkWhere();
-        for(const TransformState tsf : linkMap.keys()){
-            if (linkMap[tsf].contains(event->pos())) {
+        for(const TransformState tsf : LinkStates){
+            if (linkRect(tsf).contains(event->pos())) {
 
                 switch (tsf) {
                 case TF_Top:
@@ -641,7 +753,7 @@ void DiagramItem::mouseMoveEvent(QGraphicsSceneMouseEvent *event) {
                 h = 40;
 
             // 界面及时做出反馈
-            prepareGeometryChange();
+            markGeometryDirty();
             setPos(x, y);
             m_grapSize = QSize(w, h);
         } else {
@@ -682,17 +794,23 @@ void DiagramItem::removeArrows()
 }
 
 void DiagramItem::removePath(DiagramPath *path){
-    marks.remove(path);
-    pathes.removeAll(path);
+    for (int i = 0; i < links.size(); ++i) {
+        if (links[i].path == path) {
+            links.erase(links.begin() + i);
+            break;
+        }
+    }
     qDebug()<<"deleted";
 }
 
 void DiagramItem::removePathes(){
-    const auto pathesCopy = pathes;
-    for(DiagramPath *path : pathesCopy){
-        path->getStartItem()->marks.remove(path);
+    DiagramScene *diagramScene = qobject_cast<DiagramScene *>(scene());
+    const QVarLengthArray<PathLink, 4> linksCopy = links;
+    for(const PathLink &link : linksCopy){
+        DiagramPath *path = link.path;
+        if (diagramScene != nullptr)
+            diagramScene->cancelReroute(path);  //挂起的重算请求一并撤掉
         path->getStartItem()->removePath(path);
-        path->getEndItem()->marks.remove(path);
         path->getEndItem()->removePath(path);
         scene()->removeItem(path);
         delete path;
@@ -797,6 +915,16 @@ void DiagramItem::contextMenuEvent(QGraphicsSceneContextMenuEvent *event)
 QVariant DiagramItem::itemChange(GraphicsItemChange change, const QVariant &value)
 {
     if (change == QGraphicsItem::ItemPositionChange) {
+        //移动事务进行中 整批的连线/箭头重算留到endMove一次做 不逐项级联
+        DiagramScene *diagramScene = qobject_cast<DiagramScene *>(scene());
+        if (diagramScene != nullptr && diagramScene->moveInProgress())
+            return value;
+        if (diagramScene != nullptr) {
+            //避障开着时本图元就是别的连线的障碍 新旧位置扫过的连线要重新绕行
+            const QRectF oldRect = sceneBoundingRect();
+            diagramScene->scheduleObstacleReroutes(
+                oldRect.united(oldRect.translated(value.toPointF() - pos())));
+        }
         for (Arrow *arrow : std::as_const(arrows))
             arrow->updatePosition();
         updatePathes();
@@ -804,26 +932,11 @@ QVariant DiagramItem::itemChange(GraphicsItemChange change, const QVariant &valu
     return value;
 }
 //! [6]
+//旧接口 保留给还没迁移的调用方 热路径请直接用handleRect()
 QMap<DiagramItem::TransformState, QRectF> DiagramItem::rectWhere() {
-    static QMap<TransformState, QRectF> rectMap;
-
-    int x1 = 0;
-    int x2 = m_grapSize.width() / 2 - m_border;
-    int x3 = m_grapSize.width() - m_border * 2;
-    int y1 = 0;
-    int y2 = m_grapSize.height() / 2 - m_border;
-    int y3 = m_grapSize.height() - m_border * 2;
-    qreal borderWH = m_border * 2 / transform().m11();
-
-    rectMap[TF_TopL] = QRectF(x1, y1, borderWH, borderWH);
-    rectMap[TF_Top] = QRectF(x2, y1, borderWH, borderWH);
-    rectMap[TF_TopR] = QRectF(x3, y1, borderWH, borderWH);
-    rectMap[TF_Right] = QRectF(x3, y2, borderWH, borderWH);
-    rectMap[TF_BottomR] = QRectF(x3, y3, borderWH, borderWH);
-    rectMap[TF_Bottom] = QRectF(x2, y3, borderWH, borderWH);
-    rectMap[TF_BottomL] = QRectF(x1, y3, borderWH, borderWH);
-    rectMap[TF_Left] = QRectF(x1, y2, borderWH, borderWH);
-
+    QMap<TransformState, QRectF> rectMap;
+    for (const TransformState state : HandleStates)
+        rectMap[state] = handleRect(state);
     return rectMap;
 }
 
@@ -831,6 +944,7 @@ void DiagramItem::setRotationAngle(qreal angle)
 {
     // 设置旋转角度
     m_rotationAngle = angle;
+    markGeometryDirty();
 
     // 重新绘制图元
     update();  // 调用 update() 以重新绘制图元，使其反映新的旋转角度
@@ -843,46 +957,132 @@ qreal DiagramItem::rotationAngle() const
 
 void DiagramItem::setSize(QSizeF size){
     m_grapSize = size;
+    markGeometryDirty();
 }
 
 void DiagramItem::setWidth(qreal width){
     m_grapSize.setWidth(width);
+    markGeometryDirty();
 }
 
 void DiagramItem::setHeight(qreal height){
     m_grapSize.setHeight(height);
+    markGeometryDirty();
 }
 
 QSizeF DiagramItem::getSize(){
     return m_grapSize;
 }
 
+//旧接口 热路径请直接用linkRect()
 QMap<DiagramItem::TransformState, QRectF> DiagramItem :: linkWhere(){
-    static QMap<TransformState, QRectF> linkMap;
+    QMap<TransformState, QRectF> linkMap;
+    for (const TransformState state : LinkStates)
+        linkMap[state] = linkRect(state);
+    return linkMap;
+}
 
-    int x1 = -15;
-    int x2 = m_grapSize.width() / 2 - m_border;
-    int x3 = m_grapSize.width() - m_border * 2 + 15;
-    int y1 = -15;
-    int y2 = m_grapSize.height() / 2 - m_border;
-    int y3 = m_grapSize.height() - m_border * 2+15;
-    qreal borderWH = m_border * 2 / transform().m11();
+QString DiagramItem::labelText() const
+{
+    return textItem != nullptr ? textItem->toPlainText() : textContent;
+}
+
+void DiagramItem::setLabelText(const QString &text)
+{
+    textContent = text;
+    if (textItem != nullptr) {
+        textItem->setPlainText(text);
+    } else {
+        m_labelDirty = true;
+        update();
+    }
+}
 
-    linkMap[TF_Top] = QRectF(x2, y1, borderWH, borderWH);
-    linkMap[TF_Right] = QRectF(x3, y2, borderWH, borderWH);
-    linkMap[TF_Left] = QRectF(x1, y2, borderWH, borderWH);
-    linkMap[TF_Bottom] = QRectF(x2, y3, borderWH, borderWH);
+QFont DiagramItem::labelFont() const
+{
+    return textItem != nullptr ? textItem->font() : m_labelFont;
+}
 
-    return linkMap;
+void DiagramItem::setLabelFont(const QFont &font)
+{
+    m_labelFont = font;
+    if (textItem != nullptr) {
+        textItem->setFont(font);
+    } else {
+        m_labelDirty = true;
+        update();
+    }
+}
+
+QColor DiagramItem::labelColor() const
+{
+    return textItem != nullptr ? textItem->defaultTextColor() : m_labelColor;
 }
 
-void DiagramItem::addPathes(DiagramPath *path){
-    pathes.append(path);
+void DiagramItem::setLabelColor(const QColor &color)
+{
+    m_labelColor = color;
+    if (textItem != nullptr)
+        textItem->setDefaultTextColor(color);
+    else
+        update();
+}
+
+//提升成可编辑文本项 标签态的文字/字体/颜色原样搬过去
+//提升后不再降回 反复编辑的图元就该一直带编辑器
+void DiagramItem::promoteLabel()
+{
+    if (textItem != nullptr)
+        return;
+    DiagramTextItem *editable = new DiagramTextItem(this);
+    editable->setPlainText(textContent);
+    editable->setFont(m_labelFont);
+    editable->setDefaultTextColor(m_labelColor);
+    editable->setTextInteractionFlags(Qt::TextEditorInteraction);
+    editable->setPos(boundingRect().center() - QPointF(editable->boundingRect().width() / 2,
+                                                       editable->boundingRect().height() / 2));
+    textItem = editable;
+    update();
+}
+
+void DiagramItem::mouseDoubleClickEvent(QGraphicsSceneMouseEvent *event)
+{
+    //第一次双击时才把标签换成真正的编辑器
+    if (textItem == nullptr) {
+        promoteLabel();
+        textItem->setFocus();
+    }
+    QGraphicsItem::mouseDoubleClickEvent(event);
+}
+
+void DiagramItem::addLink(DiagramPath *path, bool isStart, quint8 anchor){
+    links.append({path, isStart, anchor});
+}
+
+const DiagramItem::PathLink *DiagramItem::findLink(DiagramPath *path) const{
+    for (const PathLink &link : links) {
+        if (link.path == path)
+            return &link;
+    }
+    return nullptr;
 }
 
 void DiagramItem::updatePathes()
 {
-    for (DiagramPath *path : std::as_const(pathes)){
-        path->updatePath();
+    //挂在DiagramScene上时走合帧批量重算 避免拖动时每个事件都重算全部连线
+    DiagramScene *diagramScene = qobject_cast<DiagramScene *>(scene());
+    if (diagramScene != nullptr) {
+        for (const PathLink &link : links)
+            diagramScene->scheduleReroute(link.path);
+        return;
+    }
+    for (const PathLink &link : links){
+        link.path->updatePath();
     }
 }
+
+void DiagramItem::updateArrows()
+{
+    for (Arrow *arrow : std::as_const(arrows))
+        arrow->updatePosition();
+}
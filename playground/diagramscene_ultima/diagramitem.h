@@ -6,8 +6,12 @@
 
 #include <QGraphicsPixmapItem>
 #include <QList>
+#include <QVarLengthArray>
+#include <QStaticText>
 #include <QBrush>
 #include <QJsonObject>
+#include <QPainterPath>
+#include <cstddef>
 
 
 
@@ -47,6 +51,9 @@ public:
                        ManualOperation,ParallelMode,Hexagon};
     DiagramType myDiagramType;
     DiagramItem(DiagramType diagramType, QMenu *contextMenu, QGraphicsItem *parent = nullptr);
+    //图元走定长块池分配 删除/撤销/粘贴循环复用内存
+    static void *operator new(std::size_t size);
+    static void operator delete(void *block, std::size_t size);
     QRectF boundingRect() const override; //重写boundingRect（）虚函数
     void setBrush(QColor &color);
 
@@ -65,9 +72,25 @@ public:
     QColor m_color;
     QColor text_color;
     QString textContent ="请输入";
-    QGraphicsTextItem *textItem;  // 添加文本框作为成员变量
-    QList<DiagramPath *> pathes;
-    QMap<DiagramPath*,QString> marks;
+    QGraphicsTextItem *textItem;  // 可编辑文本框 标签模式下为空 双击编辑时才创建
+
+    //轻量标签模式 创建/批量导入只存字符串 绘制走QStaticText缓存排版
+    //读写都过这组访问器 提升前后行为一致
+    QString labelText() const;
+    void setLabelText(const QString &text);
+    QFont labelFont() const;
+    void setLabelFont(const QFont &font);
+    QColor labelColor() const;
+    void setLabelColor(const QColor &color);
+    void promoteLabel();    //提升成可编辑的DiagramTextItem 已提升则无操作
+    //挂接连线的POD记录 原来的pathes列表+marks红黑树合并成一条
+    //快照和重算时顺序扫一块连续内存 不再查树不再拆字符串
+    struct PathLink {
+        DiagramPath *path;
+        bool isStart;   //本item是这条连线的起点端
+        quint8 anchor;  //锚点编号
+    };
+    QVarLengthArray<PathLink, 4> links; //大多数图元挂的连线很少 就地存放不碰堆
 
     void setRotationAngle(qreal angle);  // 设置旋转角度
     qreal rotationAngle() const;         // 获取当前旋转角度
@@ -80,13 +103,19 @@ public:
     void disableEvents();
     void removePath(DiagramPath *path);
     void removePathes();
-    QMap<TransformState, QRectF> rectWhere(); //绘制点
-    QMap<TransformState,QRectF> linkWhere(); // 绘制连接点
+    static const TransformState HandleStates[8]; //八个缩放控制点的槽位顺序
+    static const TransformState LinkStates[4];   //四个连接锚点的槽位顺序
+    const QRectF &handleRect(TransformState state); //缩放控制点 走缓存不分配
+    const QRectF &linkRect(TransformState state);   //连接锚点 走缓存不分配
+    QMap<TransformState, QRectF> rectWhere(); //绘制点(旧接口 由缓存拼出)
+    QMap<TransformState,QRectF> linkWhere(); // 绘制连接点(旧接口 由缓存拼出)
 
     bool showLink=false;
 
-    void addPathes(DiagramPath *path);
+    void addLink(DiagramPath *path, bool isStart, quint8 anchor);   //登记一条挂接连线
+    const PathLink *findLink(DiagramPath *path) const;  //没挂这条线时返回nullptr
     void updatePathes();
+    void updateArrows();    //一次性刷新挂接的箭头位置 移动事务结束时用
 
 
 protected:
@@ -95,14 +124,29 @@ protected:
     void hoverMoveEvent(QGraphicsSceneHoverEvent *event) override; //重载悬停函数
 
     void mouseMoveEvent(QGraphicsSceneMouseEvent *event) override; //重载移动函数
+    void mouseDoubleClickEvent(QGraphicsSceneMouseEvent *event) override; //标签模式双击才建编辑器
 
     void paint(QPainter *painter, const QStyleOptionGraphicsItem *option,
                QWidget *) override; // 重载绘画函数
 
 
 private:
+    void rebuildGeometry();     //重建缓存的轮廓路径和包围盒
+    void markGeometryDirty();   //几何变化时置脏 下次绘制前重建
+    void rebuildHandles();      //重建控制点/锚点槽位数组
+
     qreal m_rotationAngle;  // 用于存储当前图元的旋转角度
     QPolygonF myPolygon;
+    QPainterPath m_shapePath;   //缓存的轮廓路径 避免每次paint重建
+    QRectF m_boundingRect;      //缓存的包围盒
+    bool m_geomDirty = true;    //几何脏标记
+    QRectF m_handleRects[16];   //按TransformState值索引的控制点槽位
+    QRectF m_linkRects[16];     //按TransformState值索引的锚点槽位
+    bool m_handlesDirty = true; //尺寸/旋转变化后置脏
+    QFont m_labelFont;          //标签模式的字体/颜色 提升时原样搬给编辑器
+    QColor m_labelColor = Qt::black;
+    QStaticText m_labelStatic;  //缓存的标签排版 文字或字体变了才重排
+    bool m_labelDirty = true;
     QMenu *myContextMenu;
     QList<Arrow *> arrows;
 
@@ -1,5 +1,119 @@
 #include "diagrampath.h"
+#include "diagramscene.h"
+#include "connectorlayer.h"
+#include "objectpool.h"
 #include <QPainterPath>
+#include <QGraphicsScene>
+#include <array>
+
+namespace {
+//四种拐法 先横/先竖/中线竖折/中线横折
+enum ElbowKind : quint8 { Elbow_None, Elbow_HFirst, Elbow_VFirst, Elbow_MidX, Elbow_MidY };
+
+//原来drawZig里的~100个case按拐法归组 m_state=起点锚位*100+终点锚位*10+象限
+constexpr int hFirstStates[] = {882,883,811,812,813,822,823,824,182,111,112,141,
+                                411,412,414,441,444,421,423,424,283,244,223,224};
+constexpr int vFirstStates[] = {881,884,814,821,181,183,184,113,114,142,143,144,
+                                413,442,443,422,281,282,284,241,242,243,221,222};
+constexpr int midXStates[] = {842,843,121,122,481,484,213,214};
+constexpr int midYStates[] = {841,844,123,124,482,483,211,212};
+
+//状态空间很小且可全枚举 编译期直接摊平成查表 运行时一次下标访问
+constexpr std::array<quint8, 885> buildRouteTable()
+{
+    std::array<quint8, 885> table{};
+    for (int state : hFirstStates)
+        table[state] = Elbow_HFirst;
+    for (int state : vFirstStates)
+        table[state] = Elbow_VFirst;
+    for (int state : midXStates)
+        table[state] = Elbow_MidX;
+    for (int state : midYStates)
+        table[state] = Elbow_MidY;
+    return table;
+}
+constexpr std::array<quint8, 885> routeTable = buildRouteTable();
+
+//某种拐法对应的中间拐点
+QVector<QPointF> elbowWaypoints(quint8 kind, const QPointF &startPoint, const QPointF &endPoint)
+{
+    const QPointF midPoint((startPoint.x()+endPoint.x())/2,(startPoint.y()+endPoint.y())/2);
+    QVector<QPointF> waypoints;
+    switch (kind) {
+    case Elbow_HFirst:
+        waypoints.append(QPointF(endPoint.x(), startPoint.y()));
+        break;
+    case Elbow_VFirst:
+        waypoints.append(QPointF(startPoint.x(), endPoint.y()));
+        break;
+    case Elbow_MidX:
+        waypoints.append(QPointF(midPoint.x(), startPoint.y()));
+        waypoints.append(QPointF(midPoint.x(), endPoint.y()));
+        break;
+    case Elbow_MidY:
+        waypoints.append(QPointF(startPoint.x(), midPoint.y()));
+        waypoints.append(QPointF(endPoint.x(), midPoint.y()));
+        break;
+    default:
+        break;
+    }
+    return waypoints;
+}
+
+bool s_avoidObstacles = false;
+bool s_batchedRendering = false;
+//全局路由代号 避障开关每翻转一次加一 所有路由缓存随之失效
+quint32 s_routeEpoch = 0;
+}
+
+void DiagramPath::setObstacleAvoidance(bool enable)
+{
+    if (enable == s_avoidObstacles)
+        return;
+    s_avoidObstacles = enable;
+    ++s_routeEpoch; //换了路由策略 端点没动的连线也要重解
+}
+
+bool DiagramPath::obstacleAvoidance()
+{
+    return s_avoidObstacles;
+}
+
+void DiagramPath::setBatchedRendering(bool enable)
+{
+    s_batchedRendering = enable;
+}
+
+bool DiagramPath::batchedRendering()
+{
+    return s_batchedRendering;
+}
+
+//每个线程一个定长块池 GUI线程不加锁 无头导出各工作线程互不干扰
+//连线在哪条线程上建就在哪条线程上删 块不跨线程
+static FixedBlockPool &pathPool()
+{
+    static thread_local FixedBlockPool pool(sizeof(DiagramPath));
+    return pool;
+}
+
+void *DiagramPath::operator new(std::size_t size)
+{
+    if (size != sizeof(DiagramPath))
+        return ::operator new(size);
+    return pathPool().allocate();
+}
+
+void DiagramPath::operator delete(void *block, std::size_t size)
+{
+    if (block == nullptr)
+        return;
+    if (size != sizeof(DiagramPath)) {
+        ::operator delete(block);
+        return;
+    }
+    pathPool().deallocate(block);
+}
 
 
 DiagramPath::DiagramPath(DiagramItem *startItem,DiagramItem *endItem,
@@ -9,8 +123,8 @@ DiagramPath::DiagramPath(DiagramItem *startItem,DiagramItem *endItem,
     endItem(endItem),startState(startState),endState(endState)
 {
     setFlag(QGraphicsItem::ItemIsSelectable,true);
-    QPointF startpoint = startItem->mapToScene(startItem->linkWhere()[startState].center());
-    QPointF endpoint = endItem->mapToScene(endItem->linkWhere()[endState].center());
+    QPointF startpoint = startItem->mapToScene(startItem->linkRect(startState).center());
+    QPointF endpoint = endItem->mapToScene(endItem->linkRect(endState).center());
 
     m_quad = quad(startpoint,endpoint);
 
@@ -19,11 +133,18 @@ DiagramPath::DiagramPath(DiagramItem *startItem,DiagramItem *endItem,
 
 void DiagramPath::updatePath(){
 
-    QPointF startpoint = startItem->mapToScene(startItem->linkWhere()[startState].center());
-    QPointF endpoint = endItem->mapToScene(endItem->linkWhere()[endState].center());
+    QPointF startpoint = startItem->mapToScene(startItem->linkRect(startState).center());
+    QPointF endpoint = endItem->mapToScene(endItem->linkRect(endState).center());
 
-    QPointF startRectPoint = startItem->mapToScene(startItem->rectWhere()[startState].center());
-    QPointF endRectPoint = endItem->mapToScene(endItem->rectWhere()[endState].center());
+    QPointF startRectPoint = startItem->mapToScene(startItem->handleRect(startState).center());
+    QPointF endRectPoint = endItem->mapToScene(endItem->handleRect(endState).center());
+
+    //四个关键点都没动且路由代号没变就不重解 群移后的重算风暴里大多数连线端点其实没变
+    if (m_routeCached && m_routeEpoch == s_routeEpoch
+            && startpoint == m_cachedStart && endpoint == m_cachedEnd
+            && startRectPoint == m_cachedStartRect && endRectPoint == m_cachedEndRect) {
+        return;
+    }
 
     m_quad = quad(startpoint,endpoint);
 
@@ -44,6 +165,59 @@ void DiagramPath::updatePath(){
 
     // m_path = m_path;
     setPath(m_path);
+
+    m_cachedStart = startpoint;
+    m_cachedEnd = endpoint;
+    m_cachedStartRect = startRectPoint;
+    m_cachedEndRect = endRectPoint;
+    m_routeCached = true;
+    m_routeEpoch = s_routeEpoch;
+
+    //批量模式下单条重算完做一次增量刷新 完整收缩包围盒留给场景的统一refresh
+    if (m_batched) {
+        if (DiagramScene *diagramScene = qobject_cast<DiagramScene *>(scene()))
+            diagramScene->connectorLayer()->pathUpdated(this);
+    }
+}
+
+//别的图元移进/移出了本线的路线 端点没动但绕法该变了
+void DiagramPath::invalidateRoute()
+{
+    m_routeCached = false;
+}
+
+QVariant DiagramPath::itemChange(GraphicsItemChange change, const QVariant &value)
+{
+    if (change == QGraphicsItem::ItemSceneChange) {
+        //离开旧场景前先从聚合层注销
+        if (m_batched) {
+            if (DiagramScene *diagramScene = qobject_cast<DiagramScene *>(scene()))
+                diagramScene->connectorLayer()->unregisterPath(this);
+            m_batched = false;
+        }
+    } else if (change == QGraphicsItem::ItemSceneHasChanged) {
+        if (s_batchedRendering) {
+            if (DiagramScene *diagramScene = qobject_cast<DiagramScene *>(scene())) {
+                diagramScene->connectorLayer()->registerPath(this);
+                m_batched = true;
+            }
+        }
+    } else if (change == QGraphicsItem::ItemSelectedHasChanged && m_batched) {
+        //选中态高亮也由聚合层画 状态变了要它重绘
+        if (DiagramScene *diagramScene = qobject_cast<DiagramScene *>(scene()))
+            diagramScene->connectorLayer()->update();
+    }
+    return QGraphicsPathItem::itemChange(change, value);
+}
+
+void DiagramPath::paint(QPainter *painter, const QStyleOptionGraphicsItem *option,
+                        QWidget *widget)
+{
+    //已登记到聚合层的连线跳过自绘 几何在ConnectorLayer一遍画完
+    //本图元只剩命中测试和选中职责
+    if (m_batched)
+        return;
+    QGraphicsPathItem::paint(painter, option, widget);
 }
 
 void DiagramPath::drawHead(QPointF endpoint,QPointF endRectPoint){
@@ -85,89 +259,54 @@ int DiagramPath::quad(QPointF startPoint, QPointF endPoint)
     }else{return 0;}
 }
 
-void DiagramPath::drawZig(QPointF startPoint,QPointF endPoint)
+//线段膨胀成细条后问场景空间索引 是否压到两端以外的图元
+bool DiagramPath::segmentBlocked(const QPointF &a, const QPointF &b) const
 {
-    QPointF midPoint((startPoint.x()+endPoint.x())/2,(startPoint.y()+endPoint.y())/2);
-    switch (m_state) {
-    case 882:
-    case 883:
-    case 811:
-    case 812:
-    case 813:
-    case 822:
-    case 823:
-    case 824:
-    case 182:
-    case 111:
-    case 112:
-    case 141:
-    case 411:
-    case 412:
-    case 414:
-    case 441:
-    case 444:
-    case 421:
-    case 423:
-    case 424:
-    case 283:
-    case 244:
-    case 223:
-    case 224:
-        m_path.lineTo(QPointF(endPoint.x(),startPoint.y()));
-        break;
-    case 881:
-    case 884:
-    case 814:
-    case 821:
-    case 181:
-    case 183:
-    case 184:
-    case 113:
-    case 114:
-    case 142:
-    case 143:
-    case 144:
-    case 413:
-    case 442:
-    case 443:
-    case 422:
-    case 281:
-    case 282:
-    case 284:
-    case 241:
-    case 242:
-    case 243:
-    case 221:
-    case 222:
-        m_path.lineTo(startPoint.x(),endPoint.y());
-        break;
-    case 842:
-    case 843:
-    case 121:
-    case 122:
-    case 481:
-    case 484:
-    case 213:
-    case 214:{
-        m_path.lineTo(midPoint.x(),startPoint.y());
-        m_path.lineTo(midPoint.x(),endPoint.y());
-        break;
-    }
-    case 841:
-    case 844:
-    case 123:
-    case 124:
-    case 482:
-    case 483:
-    case 211:
-    case 212:{
-        m_path.lineTo(startPoint.x(),midPoint.y());
-        m_path.lineTo(endPoint.x(),midPoint.y());
-        break;
+    if (scene() == nullptr)
+        return false;
+    const QRectF band = QRectF(a, b).normalized().adjusted(-1, -1, 1, 1);
+    const QList<QGraphicsItem *> hits = scene()->items(band);
+    for (QGraphicsItem *hit : hits) {
+        DiagramItem *item = qgraphicsitem_cast<DiagramItem *>(hit);
+        if (item != nullptr && item != startItem && item != endItem)
+            return true;
     }
-    default:
-        break;
+    return false;
+}
+
+void DiagramPath::drawZig(QPointF startPoint,QPointF endPoint)
+{
+    const quint8 tableKind = (m_state >= 0 && m_state < int(routeTable.size()))
+            ? routeTable[m_state] : quint8(Elbow_None);
+
+    QVector<QPointF> waypoints = elbowWaypoints(tableKind, startPoint, endPoint);
+
+    if (s_avoidObstacles && tableKind != Elbow_None) {
+        //默认拐法压到图元就换一种试 全都压就维持默认
+        const quint8 candidates[] = {tableKind, Elbow_HFirst, Elbow_VFirst,
+                                     Elbow_MidX, Elbow_MidY};
+        for (quint8 kind : candidates) {
+            QVector<QPointF> tryPoints = elbowWaypoints(kind, startPoint, endPoint);
+            bool blocked = false;
+            QPointF prev = startPoint;
+            for (const QPointF &waypoint : std::as_const(tryPoints)) {
+                if (segmentBlocked(prev, waypoint)) {
+                    blocked = true;
+                    break;
+                }
+                prev = waypoint;
+            }
+            if (!blocked && segmentBlocked(prev, endPoint))
+                blocked = true;
+            if (!blocked) {
+                waypoints = tryPoints;
+                break;
+            }
+        }
     }
+
+    for (const QPointF &waypoint : std::as_const(waypoints))
+        m_path.lineTo(waypoint);
 }
 
 DiagramItem* DiagramPath::getStartItem(){
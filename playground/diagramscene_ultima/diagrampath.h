@@ -4,6 +4,7 @@
 #include <QGraphicsPathItem>
 #include "diagramitem.h"
 #include <QPainterPath>
+#include <cstddef>
 
 class DiagramPath : public QGraphicsPathItem
 {
@@ -18,14 +19,30 @@ public:
     DiagramPath(DiagramItem *startItem,DiagramItem *endItem,
                 DiagramItem::TransformState startState,
                 DiagramItem::TransformState endState,QGraphicsItem *parent=nullptr);
+    //连线和图元一样走定长块池分配
+    static void *operator new(std::size_t size);
+    static void operator delete(void *block, std::size_t size);
 
     int type() const override { return Type; }
 
     void updatePath();
+    void invalidateRoute(); //障碍分布变了 丢掉缓存路由 下次updatePath强制重解
     DiagramItem * getStartItem();
     DiagramItem * getEndItem();
 
+    //避障路由开关 打开后拐点会绕开路径上的其他图元
+    static void setObstacleAvoidance(bool enable);
+    static bool obstacleAvoidance();
+
+    //批量绘制开关 打开后新挂进场景的连线登记到ConnectorLayer统一绘制
+    //建议启动时设置 已在场景里的连线不会追加登记
+    static void setBatchedRendering(bool enable);
+    static bool batchedRendering();
+
 protected:
+    QVariant itemChange(GraphicsItemChange change, const QVariant &value) override;
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option,
+               QWidget *widget) override;
 
 private:
     DiagramItem *startItem;
@@ -43,9 +60,20 @@ private:
     int m_quad;
     int m_state;
 
+    //路由缓存 锚点没动的连线不重解 群移后的重算风暴里大多数端点其实没动
+    QPointF m_cachedStart;
+    QPointF m_cachedEnd;
+    QPointF m_cachedStartRect;
+    QPointF m_cachedEndRect;
+    bool m_routeCached = false;
+    quint32 m_routeEpoch = 0;   //缓存路由对应的全局路由代号 避障开关翻转时整体作废
+
+    bool m_batched = false; //已登记到聚合连线层 自身paint被跳过
+
     void drawHead(QPointF endPoint,QPointF endRectPoint);
     int quad(QPointF startPoint,QPointF endPoint);
     void drawZig(QPointF startPoint,QPointF endPoint);
+    bool segmentBlocked(const QPointF &a, const QPointF &b) const;  //线段是否穿过其他图元
 };
 
 #endif // DIAGRAMPATH_H
@@ -6,11 +6,14 @@
 #include "diagramitem.h"
 #include "qaction.h"
 #include "diagrampath.h"
+#include "connectorlayer.h"
 
 #include <QGraphicsSceneMouseEvent>
 #include <QTextCursor>
 #include <QPainter>
+#include <QPixmap>
 #include <QTimer>
+#include "perftrace.h"
 
 //! [0]
 bool isInsertPath = false;
@@ -101,10 +104,17 @@ void DiagramScene::editorLostFocus(DiagramTextItem *item)
     item->setTextCursor(cursor);
 
     if (item->toPlainText().isEmpty()) {
-        removeItem(item);
-        item->deleteLater();
+        //不在这里直接delete 撤销栈里的命令可能还引用这个项
+        //交给主窗口压一条删除命令 移除和释放都由命令负责
+        emit textRemoved(item);
     }
 }
+
+//文本项失焦时自己调这里 连图元内部的标签一起覆盖
+void DiagramScene::notifyTextEdited(DiagramTextItem *item)
+{
+    emit textEdited(item);
+}
 //! [5]
 void DiagramScene::keyPressEvent(QKeyEvent *event)
 {
@@ -181,10 +191,21 @@ void DiagramScene::mousePressEvent(QGraphicsSceneMouseEvent *mouseEvent)
             // Shift 键被按下，进入框选模式
             beginpoint = mouseEvent->scenePos();
             ischeckingbox = true;
+            bandRect = QRectF();
+            bandSelected.clear();
         } else {
             // 正常的图元移动逻辑
             movedItem = itemAt(mouseEvent->scenePos(), QTransform());  // 获取当前鼠标下的图元
-            if (movedItem != nullptr) {
+            if (movedItem != nullptr && movedItem->isSelected() && selectedItems().size() > 1) {
+                // 按住的是多选中的图元 整批进移动事务 不走单图元的吸附路径
+                beginMove(selectedItems());
+                moveLastScenePos = mouseEvent->scenePos();
+                movedItem = nullptr;
+            }
+            else if (movedItem != nullptr) {
+                movedItemOldPos = movedItem->pos();  // 记录起始位置 拖动结束时生成位移命令
+                // 拖动期间其他图元不动 索引整个拖动过程只建这一次
+                alignIndex.rebuild(items(), movedItem);
                 // 确保 movedItem 是 DiagramItem 类型，以便访问 isMoving
                 DiagramItem *diagramItem = qgraphicsitem_cast<DiagramItem*>(movedItem);
                 if (diagramItem != nullptr) {
@@ -217,7 +238,7 @@ void DiagramScene::mouseMoveEvent(QGraphicsSceneMouseEvent *mouseEvent)
         line->setLine(newLine);
     } else if (myMode == MoveItem) {
         if (mouseEvent->modifiers() == Qt::ShiftModifier && ischeckingbox) {
-            // 框选逻辑，保持不变
+            // 框选逻辑 选中状态跟着矩形边沿增量变 setRect自带精确脏区
             endpoint = mouseEvent->scenePos();
             qreal width = endpoint.rx() - beginpoint.rx();
             qreal height = endpoint.ry() - beginpoint.ry();
@@ -229,7 +250,17 @@ void DiagramScene::mouseMoveEvent(QGraphicsSceneMouseEvent *mouseEvent)
             } else {
                 rectItem->setRect(QRectF(beginpoint, QSizeF(width, height)));
             }
-            update();
+            updateBandSelection(QRectF(beginpoint, endpoint).normalized());
+        }
+        else if (moveActive && (mouseEvent->buttons() & Qt::LeftButton)) {
+            // 多选拖动 每个鼠标事件对整批应用一次位移 不走默认的逐图元拖动
+            const QPointF delta = mouseEvent->scenePos() - moveLastScenePos;
+            moveLastScenePos = mouseEvent->scenePos();
+            applyMoveDelta(delta);
+            // 连线跟手 入队合帧重算 一帧内每条只算一次 完整收尾仍在endMove
+            for (DiagramPath *path : std::as_const(movePaths))
+                scheduleReroute(path);
+            return;
         }
         else {
             // 拖拽图元的逻辑
@@ -250,81 +281,59 @@ void DiagramScene::mouseMoveEvent(QGraphicsSceneMouseEvent *mouseEvent)
                 iscenterY = false;  // 清除 Y 方向中心对齐状态
                 alignedItem = nullptr;
 
-                QPointF newPosition = movedItem->pos();
                 QPointF suggestedPosition = movedItem->pos();  // 用来保存潜在的吸附位置，但不立即应用
 
-                // 遍历场景中的所有图元
-                foreach (QGraphicsItem *item, items()) {
-                    // 类型检查和排除当前正在移动的图元
-                    DiagramItem *diagramItem = qgraphicsitem_cast<DiagramItem*>(item);
-                    DiagramItem *diagramMovedItem = qgraphicsitem_cast<DiagramItem*>(movedItem);
-
-                    if (diagramItem != nullptr && diagramMovedItem != nullptr && diagramItem != diagramMovedItem) {
-                        QRectF movedRect = diagramMovedItem->sceneBoundingRect();
-                        QRectF itemRect = diagramItem->sceneBoundingRect();
-
-                        // 计算左边界的水平距离
-                        qreal x_distance = movedRect.left() - itemRect.left();
-                        // 计算顶边界的垂直距离
-                        qreal y_distance = movedRect.top() - itemRect.top();
-                        // 计算右边界的水平距离
-                        qreal right_distance = movedRect.right() - itemRect.right();
-                        // 计算底边界的垂直距离
-                        qreal bottom_distance = movedRect.bottom() - itemRect.bottom();
-                        // 计算中心对齐的水平距离（X 方向）
-                        qreal center_x_distance = movedRect.center().x() - itemRect.center().x();
-                        // 计算中心对齐的垂直距离（Y 方向）
-                        qreal center_y_distance = movedRect.center().y() - itemRect.center().y();
-
-                        // 检测水平对齐
-                        if (qAbs(x_distance) < 50) {
-                            isleft = true;  // 设置水平对齐标志
-                            alignedItem = item;
-                            // newPosition.setX(itemRect.left());  // 吸附到 x 轴
-                            suggestedPosition.setX(itemRect.left());  // 保存潜在的X坐标
-                            needAlignX = true;
-                        }
-
-                        // 检测垂直对齐
-                        if (qAbs(y_distance) < 50) {
-                            istop = true;   // 设置垂直对齐标志
-                            alignedItem = item;
-                            // newPosition.setY(itemRect.top());  // 吸附到 y 轴
-                            suggestedPosition.setY(itemRect.top());  // 保存潜在的Y坐标
-                            needAlignY = true;
-                        }
-
-                        // 检测右边界的水平对齐
-                        if (qAbs(right_distance) < 50) {
-                            isright = true;  // 新增：设置右边界对齐标志
-                            alignedItem = item;
-                            suggestedPosition.setX(itemRect.right() - movedRect.width());  // 吸附到右边界
-                            needAlignRight = true;
-                        }
-
-                        // 检测底边界的垂直对齐
-                        if (qAbs(bottom_distance) < 50) {
-                            isbottom = true;  // 新增：设置底边界对齐标志
-                            alignedItem = item;
-                            suggestedPosition.setY(itemRect.bottom() - movedRect.height());  // 吸附到底边界
-                            needAlignBottom = true;
-                        }
-
-                        // 检测中心对齐（X 方向）
-                        if (qAbs(center_x_distance) < 50) {
-                            iscenterX = true;  // 设置中心对齐标志
-                            alignedItem = item;
-                            // newPosition.setX(itemRect.center().x() - movedRect.width() / 2);  // 中心对齐吸附
-                            suggestedPosition.setX(itemRect.center().x() - movedRect.width() / 2 + 20);  // 保存潜在的中心对齐位置
-                            needAlignCenterX = true;
-                        }
-                        // 检测中心对齐（Y 方向）
-                        if (qAbs(center_y_distance) < 50) {
-                            iscenterY = true;  // 新增：设置中心对齐标志（Y 方向）
-                            alignedItem = item;
-                            suggestedPosition.setY(itemRect.center().y() - movedRect.height() / 2 + 20);  // 保存潜在的中心对齐位置（Y）
-                            needAlignCenterY = true;
-                        }
+                // 通过排序索引二分查找各方向±50内的候选 不再遍历整个场景
+                DiagramItem *diagramMovedItem = qgraphicsitem_cast<DiagramItem*>(movedItem);
+                if (diagramMovedItem != nullptr) {
+                    QRectF movedRect = diagramMovedItem->sceneBoundingRect();
+                    AlignmentIndex::Match match;
+
+                    // 检测水平对齐
+                    if (alignIndex.nearestLeft(movedRect.left(), 50, match)) {
+                        isleft = true;  // 设置水平对齐标志
+                        alignedItem = match.item;
+                        suggestedPosition.setX(match.value);  // 保存潜在的X坐标
+                        needAlignX = true;
+                    }
+
+                    // 检测垂直对齐
+                    if (alignIndex.nearestTop(movedRect.top(), 50, match)) {
+                        istop = true;   // 设置垂直对齐标志
+                        alignedItem = match.item;
+                        suggestedPosition.setY(match.value);  // 保存潜在的Y坐标
+                        needAlignY = true;
+                    }
+
+                    // 检测右边界的水平对齐
+                    if (alignIndex.nearestRight(movedRect.right(), 50, match)) {
+                        isright = true;  // 设置右边界对齐标志
+                        alignedItem = match.item;
+                        suggestedPosition.setX(match.value - movedRect.width());  // 吸附到右边界
+                        needAlignRight = true;
+                    }
+
+                    // 检测底边界的垂直对齐
+                    if (alignIndex.nearestBottom(movedRect.bottom(), 50, match)) {
+                        isbottom = true;  // 设置底边界对齐标志
+                        alignedItem = match.item;
+                        suggestedPosition.setY(match.value - movedRect.height());  // 吸附到底边界
+                        needAlignBottom = true;
+                    }
+
+                    // 检测中心对齐（X 方向）
+                    if (alignIndex.nearestCenterX(movedRect.center().x(), 50, match)) {
+                        iscenterX = true;  // 设置中心对齐标志
+                        alignedItem = match.item;
+                        suggestedPosition.setX(match.value - movedRect.width() / 2 + 20);  // 保存潜在的中心对齐位置
+                        needAlignCenterX = true;
+                    }
+                    // 检测中心对齐（Y 方向）
+                    if (alignIndex.nearestCenterY(movedRect.center().y(), 50, match)) {
+                        iscenterY = true;  // 设置中心对齐标志（Y 方向）
+                        alignedItem = match.item;
+                        suggestedPosition.setY(match.value - movedRect.height() / 2 + 20);  // 保存潜在的中心对齐位置（Y）
+                        needAlignCenterY = true;
                     }
                 }
 
@@ -332,7 +341,15 @@ void DiagramScene::mouseMoveEvent(QGraphicsSceneMouseEvent *mouseEvent)
                 if (needAlignX || needAlignY || needAlignRight || needAlignBottom || needAlignCenterX || needAlignCenterY) {
                     // movedItem->setPos(newPosition);
                     alignPosition = suggestedPosition;  // 保存潜在的对齐位置，待 release 时处理
-                    update();  // 更新辅助线的绘制
+                }
+
+                // 辅助线只占几条1px的窄条 失效新旧窄条的并集即可 不再整幅前景重绘
+                const QRectF newGuideRect = guideDamageRect();
+                if (newGuideRect != lastGuideRect) {
+                    const QRectF damage = lastGuideRect.united(newGuideRect);
+                    lastGuideRect = newGuideRect;
+                    if (!damage.isNull())
+                        update(damage);
                 }
             }
         }
@@ -344,78 +361,200 @@ void DiagramScene::mouseMoveEvent(QGraphicsSceneMouseEvent *mouseEvent)
     }
 }
 //! [10]
+//虚线图章 只画一次 之后整条辅助线用平铺代替逐段描线
+static QPixmap makeGuideTile(bool vertical)
+{
+    QPixmap tile(vertical ? QSize(1, 6) : QSize(6, 1));
+    tile.fill(Qt::transparent);
+    QPainter tilePainter(&tile);
+    tilePainter.fillRect(0, 0, vertical ? 1 : 4, vertical ? 4 : 1, Qt::black);
+    return tile;
+}
+
+//当前所有激活辅助线占的窄条并集 mouseMove里用它算局部脏区
+QRectF DiagramScene::guideDamageRect() const
+{
+    if (movedItem == nullptr || alignedItem == nullptr)
+        return QRectF();
+    QRectF movedRect = movedItem->sceneBoundingRect();
+    QRectF itemRect = alignedItem->sceneBoundingRect();
+    const qreal topY = qMin(itemRect.top(), movedRect.top()) - 20;
+    const qreal bottomY = qMax(itemRect.bottom(), movedRect.bottom()) + 20;
+    const qreal leftX = qMin(itemRect.left(), movedRect.left()) - 20;
+    const qreal rightX = qMax(itemRect.right(), movedRect.right()) + 20;
+
+    QRectF damage;
+    if (isleft)
+        damage = damage.united(QRectF(itemRect.left()+6, topY, 1, bottomY - topY));
+    if (isright)
+        damage = damage.united(QRectF(itemRect.right()-6, topY, 1, bottomY - topY));
+    if (istop)
+        damage = damage.united(QRectF(leftX, itemRect.top()+6, rightX - leftX, 1));
+    if (isbottom)
+        damage = damage.united(QRectF(leftX, itemRect.bottom()-6, rightX - leftX, 1));
+    if (iscenterX)
+        damage = damage.united(QRectF(itemRect.center().x(), topY, 1, bottomY - topY));
+    if (iscenterY)
+        damage = damage.united(QRectF(leftX, itemRect.center().y(), rightX - leftX, 1));
+    // 外扩2px盖住虚线的反走样边缘
+    return damage.isNull() ? damage : damage.adjusted(-2, -2, 2, 2);
+}
+
+void DiagramScene::setBackgroundTile(const QPixmap &tile)
+{
+    bgTile = tile;
+    bgScaledTile = QPixmap();   //换样式后下一帧按当前缩放重建
+    bgCachedScale = 0;
+    update();
+}
+
+//背景平铺走缓存图块 每档缩放只缩放一次 之后滚动全是整块blit
+void DiagramScene::drawBackground(QPainter *painter, const QRectF &rect)
+{
+    if (bgTile.isNull()) {
+        QGraphicsScene::drawBackground(painter, rect);
+        return;
+    }
+    const QTransform worldTransform = painter->worldTransform();
+    const qreal scale = worldTransform.m11();
+    if (bgScaledTile.isNull() || !qFuzzyCompare(scale, bgCachedScale)) {
+        bgScaledTile = qFuzzyCompare(scale, 1.0) ? bgTile
+            : bgTile.scaled(qMax(1, qRound(bgTile.width() * scale)),
+                            qMax(1, qRound(bgTile.height() * scale)),
+                            Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+        bgCachedScale = scale;
+    }
+    //在设备坐标里平铺 图块锚定在场景原点 不随曝光区错位
+    painter->save();
+    painter->resetTransform();
+    const QRectF deviceRect = worldTransform.mapRect(rect);
+    const QPointF origin = worldTransform.map(QPointF(0, 0));
+    painter->drawTiledPixmap(deviceRect, bgScaledTile, deviceRect.topLeft() - origin);
+    painter->restore();
+}
+
 void DiagramScene::drawForeground(QPainter *painter, const QRectF &rect)
 {
-    QPen pen;
-    pen.setStyle(Qt::DashLine);  // 使用虚线绘制辅助线
-    painter->setPen(pen);
+    // 虚线图章缓存 水平/垂直各一张
+    static const QPixmap hTile = makeGuideTile(false);
+    static const QPixmap vTile = makeGuideTile(true);
 
     // 输出对齐辅助线的相关信息
     if (movedItem != nullptr && alignedItem != nullptr) {
-        // 打印当前正在拖拽的图元的坐标
+        // 当前正在拖拽的图元的边界
         QRectF movedRect = movedItem->sceneBoundingRect();
-        // qDebug() << "正在拖拽的图元左边界: " << movedRect.left()
-        //          << ", 顶边: " << movedRect.top()
-        //          << ", 中心 X 坐标: " << movedRect.center().x()
-        //          << ", 宽度: " << movedRect.width()
-        //          << ", 高度: " << movedRect.height();
 
         QRectF itemRect = alignedItem->sceneBoundingRect();  // 获取 alignedItem 的边界
-        // qDebug() << "对齐图元的左边界: " << itemRect.left()
-        //          << ", 顶边: " << itemRect.top()
-        //          << ", 中心 X 坐标: " << itemRect.center().x();
-
-        // qDebug() << "场景矩形的顶部: " << rect.top()
-        //          << ", 底部: " << rect.bottom()
-        //          << ", 左边: " << rect.left()
-        //          << ", 右边: " << rect.right();
 
+        // 落在曝光区外的辅助线直接跳过 曝光区只有新旧窄条的并集
         // 如果需要绘制左边界垂直辅助线
         if (isleft) {
-            // qDebug() << "正在绘制左边界垂直辅助线，x 位置: " << itemRect.left();
             qreal topY = qMin(itemRect.top(), movedRect.top());  // 辅助线的顶部坐标
             qreal bottomY = qMax(itemRect.bottom(), movedRect.bottom());  // 辅助线的底部坐标
-            painter->drawLine(itemRect.left()+6, topY - 20, itemRect.left()+6, bottomY + 20);
+            const QRectF guide(itemRect.left()+6, topY - 20, 1, bottomY - topY + 40);
+            if (guide.intersects(rect))
+                painter->drawTiledPixmap(guide, vTile);
         }
         // 如果需要绘制右边界的垂直辅助线
         if (isright) {
-            // qDebug() << "正在绘制右边界垂直辅助线，x 位置: " << itemRect.right();
             // 辅助线长度为 alignedItem 和 movedItem 的 y 范围
             qreal topY = qMin(itemRect.top(), movedRect.top());  // 辅助线的顶部坐标
             qreal bottomY = qMax(itemRect.bottom(), movedRect.bottom());  // 辅助线的底部坐标
-            painter->drawLine(itemRect.right()-6, topY - 20, itemRect.right()-6, bottomY + 20);  // 绘制右边界辅助线
+            const QRectF guide(itemRect.right()-6, topY - 20, 1, bottomY - topY + 40);
+            if (guide.intersects(rect))
+                painter->drawTiledPixmap(guide, vTile);  // 绘制右边界辅助线
         }
         // 如果需要绘制顶边界的水平辅助线
         if (istop) {
-            // qDebug() << "正在绘制顶边界垂直辅助线，y 位置: " << itemRect.top();
             qreal leftX = qMin(itemRect.left(), movedRect.left());  // 辅助线的左侧坐标
             qreal rightX = qMax(itemRect.right(), movedRect.right());  // 辅助线的右侧坐标
-            painter->drawLine(leftX - 20, itemRect.top()+6, rightX + 20, itemRect.top()+6);
+            const QRectF guide(leftX - 20, itemRect.top()+6, rightX - leftX + 40, 1);
+            if (guide.intersects(rect))
+                painter->drawTiledPixmap(guide, hTile);
         }
         // 如果需要绘制底边界的水平辅助线
         if (isbottom) {
-            // qDebug() << "正在绘制底边界水平辅助线，y 位置: " << itemRect.bottom();
             // 辅助线长度为 alignedItem 和 movedItem 的 x 范围
             qreal leftX = qMin(itemRect.left(), movedRect.left());  // 辅助线的左侧坐标
             qreal rightX = qMax(itemRect.right(), movedRect.right());  // 辅助线的右侧坐标
-            painter->drawLine(leftX- 20, itemRect.bottom()-6, rightX+ 20, itemRect.bottom()-6);  // 绘制底边界辅助线
+            const QRectF guide(leftX - 20, itemRect.bottom()-6, rightX - leftX + 40, 1);
+            if (guide.intersects(rect))
+                painter->drawTiledPixmap(guide, hTile);  // 绘制底边界辅助线
         }
         // 如果需要绘制中心对齐的垂直辅助线（X 方向中心对齐）
         if (iscenterX) {
-            // qDebug() << "正在绘制中心对齐的垂直辅助线，中心 X 坐标: " << itemRect.center().x();
             qreal topY = qMin(itemRect.top(), movedRect.top());  // 辅助线的顶部坐标
             qreal bottomY = qMax(itemRect.bottom(), movedRect.bottom());  // 辅助线的底部坐标
-            painter->drawLine(itemRect.center().x(), topY - 20, itemRect.center().x(), bottomY + 20);
+            const QRectF guide(itemRect.center().x(), topY - 20, 1, bottomY - topY + 40);
+            if (guide.intersects(rect))
+                painter->drawTiledPixmap(guide, vTile);
         }
 
         // 如果需要绘制中心对齐的水平辅助线（Y 方向中心对齐）
         if (iscenterY) {
-            // qDebug() << "正在绘制中心对齐的水平辅助线，中心 Y 坐标: " << itemRect.center().y();
             qreal leftX = qMin(itemRect.left(), movedRect.left());  // 辅助线的左侧坐标
             qreal rightX = qMax(itemRect.right(), movedRect.right());  // 辅助线的右侧坐标
-            painter->drawLine(leftX - 20, itemRect.center().y(), rightX + 20, itemRect.center().y());
+            const QRectF guide(leftX - 20, itemRect.center().y(), rightX - leftX + 40, 1);
+            if (guide.intersects(rect))
+                painter->drawTiledPixmap(guide, hTile);
+        }
+    }
+}
+
+//矩形差集 a里不被b覆盖的部分 最多拆成上下左右四条
+static int subtractRect(const QRectF &a, const QRectF &b, QRectF out[4])
+{
+    if (a.isEmpty())
+        return 0;
+    const QRectF overlap = a.intersected(b);
+    if (overlap.isEmpty()) {
+        out[0] = a;
+        return 1;
+    }
+    int n = 0;
+    if (overlap.top() > a.top())
+        out[n++] = QRectF(a.left(), a.top(), a.width(), overlap.top() - a.top());
+    if (overlap.bottom() < a.bottom())
+        out[n++] = QRectF(a.left(), overlap.bottom(), a.width(), a.bottom() - overlap.bottom());
+    if (overlap.left() > a.left())
+        out[n++] = QRectF(a.left(), overlap.top(), overlap.left() - a.left(), overlap.height());
+    if (overlap.right() < a.right())
+        out[n++] = QRectF(overlap.right(), overlap.top(), a.right() - overlap.right(), overlap.height());
+    return n;
+}
+
+//框选增量更新 每次只拿新旧矩形的差分条带去查BSP索引
+//中心点进新框的选中 原先被框住但中心点出去的取消 代价只和扫过边沿的图元数成正比
+void DiagramScene::updateBandSelection(const QRectF &newRect)
+{
+    QRectF delta[4];
+    //新框长出来的部分 可能有图元进入
+    int n = subtractRect(newRect, bandRect, delta);
+    for (int i = 0; i < n; ++i) {
+        foreach (QGraphicsItem *item, items(delta[i], Qt::IntersectsItemBoundingRect)) {
+            if (item == rectItem || !(item->flags() & QGraphicsItem::ItemIsSelectable))
+                continue;
+            if (bandSelected.contains(item))
+                continue;
+            if (newRect.contains(item->mapToScene(item->boundingRect().center()))) {
+                item->setSelected(true);    //setSelected只重绘这一个图元
+                bandSelected.insert(item);
+            }
         }
     }
+    //旧框缩回去的部分 可能有图元离开
+    n = subtractRect(bandRect, newRect, delta);
+    for (int i = 0; i < n; ++i) {
+        foreach (QGraphicsItem *item, items(delta[i], Qt::IntersectsItemBoundingRect)) {
+            if (!bandSelected.contains(item))
+                continue;
+            if (!newRect.contains(item->mapToScene(item->boundingRect().center()))) {
+                item->setSelected(false);
+                bandSelected.remove(item);
+            }
+        }
+    }
+    bandRect = newRect;
 }
 
 //! [11]
@@ -449,26 +588,21 @@ void DiagramScene::mouseReleaseEvent(QGraphicsSceneMouseEvent *mouseEvent)
     }
     else if (ischeckingbox) {
         endpoint = mouseEvent->scenePos();
-        removeItem(rectItem);
-        rectItem = nullptr;
-
-        int x1 = beginpoint.rx() > endpoint.rx() ? endpoint.rx() : beginpoint.rx();
-        int x2 = beginpoint.rx() < endpoint.rx() ? endpoint.rx() : beginpoint.rx();
-        int y1 = beginpoint.ry() > endpoint.ry() ? endpoint.ry() : beginpoint.ry();
-        int y2 = beginpoint.ry() < endpoint.ry() ? endpoint.ry() : beginpoint.ry();
-
-        foreach (QGraphicsItem *item, this->items()) {
-            if (item->mapToScene(item->boundingRect().center()).rx() < x2 &&
-                item->mapToScene(item->boundingRect().center()).rx() > x1 &&
-                item->mapToScene(item->boundingRect().center()).ry() > y1 &&
-                item->mapToScene(item->boundingRect().center()).ry() < y2) {
-                item->setSelected(true);
-            }
+        //拖动过程中选中状态已经增量维护好 这里补最后一段位移的差分
+        updateBandSelection(QRectF(beginpoint, endpoint).normalized());
+        if (rectItem != nullptr) {
+            removeItem(rectItem);
+            rectItem = nullptr;
         }
+        bandRect = QRectF();
+        bandSelected.clear();
         ischeckingbox = false;
-        update();
     }
     else if (myMode == MoveItem) {
+        // 多选拖动结束 整批一次重算+一条撤销记录
+        if (moveActive)
+            endMove();
+
         // 拖拽结束后，进行吸附
         if (movedItem != nullptr) {
             // 检查是否需要对齐
@@ -493,16 +627,27 @@ void DiagramScene::mouseReleaseEvent(QGraphicsSceneMouseEvent *mouseEvent)
             iscenterY = false;  // 清除 Y 方向中心对齐状态
             alignedItem = nullptr;
 
+            // 只失效旧辅助线占的窄条 不再整幅重绘
+            const QRectF guideDamage = lastGuideRect;
+            lastGuideRect = QRectF();
 
-            QTimer::singleShot(300, this, [this]() {
-                update();  // 清除辅助线（延迟0.3秒）
+            QTimer::singleShot(300, this, [this, guideDamage]() {
+                if (!guideDamage.isNull())
+                    update(guideDamage);  // 清除辅助线（延迟0.3秒）
             });
 
+            // 拖动产生了实际位移才通知撤销引擎
+            if (movedItem->pos() != movedItemOldPos)
+                emit itemMoved(movedItem, movedItemOldPos);
+
             // 最后清除移动图元
             movedItem = nullptr;  // 清除移动图元
         }
 
-        update();  // 清除辅助线（延迟0.3秒）
+        if (!lastGuideRect.isNull()) {
+            update(lastGuideRect);  // 清除辅助线
+            lastGuideRect = QRectF();
+        }
 
     }else if(myMode == InsertPath){
 
@@ -529,8 +674,8 @@ void DiagramScene::mouseReleaseEvent(QGraphicsSceneMouseEvent *mouseEvent)
             QRectF tempRect;
 
 
-            for(DiagramItem::TransformState state : startItem->linkWhere().keys()){
-                tempRect = startItem->mapRectToScene(startItem->linkWhere()[state]);
+            for(DiagramItem::TransformState state : DiagramItem::LinkStates){
+                tempRect = startItem->mapRectToScene(startItem->linkRect(state));
                 QRectF *magnetRect = new QRectF(tempRect.topLeft()-QPointF(20,20),tempRect.size()+QSize(40,40));
                 if(  magnetRect->contains(pathLine->line().p1()) ) {
 
@@ -540,8 +685,8 @@ void DiagramScene::mouseReleaseEvent(QGraphicsSceneMouseEvent *mouseEvent)
                 }
             }
 
-            for(DiagramItem::TransformState state : endItem->linkWhere().keys()){
-                tempRect = endItem->mapRectToScene(endItem->linkWhere()[state]);
+            for(DiagramItem::TransformState state : DiagramItem::LinkStates){
+                tempRect = endItem->mapRectToScene(endItem->linkRect(state));
                 QRectF *magnetRect = new QRectF(tempRect.topLeft()-QPointF(20,20),tempRect.size()+QSize(40,40));
                 if( magnetRect->contains(pathLine->line().p2()) ) {
                     endState = state;
@@ -554,12 +699,8 @@ void DiagramScene::mouseReleaseEvent(QGraphicsSceneMouseEvent *mouseEvent)
             if(startState && endState){
                 DiagramPath *path = new DiagramPath(startItem,endItem,startState,endState);
 
-                startItem->addPathes(path);
-                startItem->marks[path] = "1" + QString::number(startState);
-                qDebug()<<startItem->marks;
-                endItem->addPathes(path);
-                endItem->marks[path] = "0" + QString::number(endState);
-                qDebug()<<endItem->marks;
+                startItem->addLink(path, true, quint8(startState));
+                endItem->addLink(path, false, quint8(endState));
                 qDebug()<<startState<<endState;
                 path->updatePath();
                 path->setZValue(-1000.0);
@@ -603,6 +744,158 @@ QGraphicsTextItem* DiagramScene::createTextItem() {
     addItem(newItem);
     return newItem;
 }
+//拖动时每个鼠标事件不再直接重算连线 先攒到集合里
+//约16ms后统一flush 一帧内同一条连线只重算一次
+//批量导入模式 导入期间每插一个图元都更新BSP树/发信号/触发重绘太亏
+//关掉索引和信号 全部挂好后一次性恢复
+void DiagramScene::beginBulkLoad()
+{
+    //整场景替换(回滚/导入)前清掉挂起的重算 免得flush时摸到已删除的连线
+    pendingReroutes.clear();
+    setItemIndexMethod(QGraphicsScene::NoIndex);
+    blockSignals(true);
+}
+
+void DiagramScene::endBulkLoad()
+{
+    blockSignals(false);
+    //切回BSP索引时Qt会对现有图元一次性重建整棵树
+    setItemIndexMethod(QGraphicsScene::BspTreeIndex);
+    refreshConnectorLayer();
+    update();
+    emit sceneLoaded();
+}
+
+//聚合连线层 按需创建 压在连线(-1000)上面 普通图元下面
+ConnectorLayer *DiagramScene::connectorLayer()
+{
+    if (myConnectorLayer == nullptr) {
+        myConnectorLayer = new ConnectorLayer();
+        myConnectorLayer->setZValue(-999);
+        addItem(myConnectorLayer);
+    }
+    return myConnectorLayer;
+}
+
+void DiagramScene::refreshConnectorLayer()
+{
+    if (myConnectorLayer != nullptr)
+        myConnectorLayer->geometryChanged();
+}
+
+//clear()会把聚合层当普通图元一起删掉 析构时回调到这里放弃缓存的指针
+void DiagramScene::connectorLayerDestroyed(ConnectorLayer *layer)
+{
+    if (myConnectorLayer == layer)
+        myConnectorLayer = nullptr;
+}
+
+//移动事务 开始时一次捕获整批图元/原始位置/关联连线
+//拖动期间itemChange里的级联被moveActive短路 结束时统一重算并发一条撤销记录
+void DiagramScene::beginMove(const QList<QGraphicsItem *> &selection)
+{
+    moveItems.clear();
+    moveOldPositions.clear();
+    movePaths.clear();
+    for (QGraphicsItem *item : selection) {
+        DiagramItem *diagramItem = qgraphicsitem_cast<DiagramItem *>(item);
+        if (diagramItem == nullptr)
+            continue;
+        diagramItem->isMoving = true;
+        moveItems.append(diagramItem);
+        moveOldPositions.append(diagramItem->pos());
+        for (const DiagramItem::PathLink &link : std::as_const(diagramItem->links))
+            movePaths.insert(link.path);
+    }
+    moveActive = !moveItems.isEmpty();
+}
+
+void DiagramScene::applyMoveDelta(const QPointF &delta)
+{
+    if (!moveActive || delta.isNull())
+        return;
+    //一次遍历整批平移 级联已被短路 没有每图元的重算风暴
+    for (DiagramItem *item : std::as_const(moveItems))
+        item->setPos(item->pos() + delta);
+}
+
+void DiagramScene::endMove(bool recordUndo)
+{
+    if (!moveActive)
+        return;
+    moveActive = false;
+
+    QList<QGraphicsItem *> changedItems;
+    QList<QPointF> oldPositions;
+    QRectF movedRegion;  //整批新旧位置扫过的区域 避障时这里面的连线要重新绕行
+    for (int i = 0; i < moveItems.size(); ++i) {
+        DiagramItem *item = moveItems.at(i);
+        item->isMoving = false;
+        item->updateArrows();
+        if (item->pos() != moveOldPositions.at(i)) {
+            const QRectF newRect = item->sceneBoundingRect();
+            movedRegion = movedRegion.united(newRect)
+                    .united(newRect.translated(moveOldPositions.at(i) - item->pos()));
+            changedItems.append(item);
+            oldPositions.append(moveOldPositions.at(i));
+        }
+    }
+    //整批只过一遍去重后的连线
+    for (DiagramPath *path : std::as_const(movePaths))
+        path->updatePath();
+    if (!movedRegion.isNull())
+        scheduleObstacleReroutes(movedRegion);
+    refreshConnectorLayer();
+
+    if (recordUndo && !changedItems.isEmpty())
+        emit itemsMoved(changedItems, oldPositions);
+
+    moveItems.clear();
+    moveOldPositions.clear();
+    movePaths.clear();
+}
+
+void DiagramScene::scheduleReroute(DiagramPath *path)
+{
+    pendingReroutes.insert(path);
+    if (!rerouteScheduled) {
+        rerouteScheduled = true;
+        QTimer::singleShot(16, this, &DiagramScene::flushReroutes);
+    }
+}
+
+void DiagramScene::cancelReroute(DiagramPath *path)
+{
+    pendingReroutes.remove(path);
+}
+
+//图元移动改变了障碍分布 路由缓存只看端点 这里要显式作废
+//把新旧位置扫过区域里的其他连线丢缓存并入队 合帧后统一重新绕行
+void DiagramScene::scheduleObstacleReroutes(const QRectF &movedRect)
+{
+    if (!DiagramPath::obstacleAvoidance())
+        return;
+    foreach (QGraphicsItem *item, items(movedRect, Qt::IntersectsItemBoundingRect)) {
+        if (DiagramPath *path = qgraphicsitem_cast<DiagramPath *>(item)) {
+            path->invalidateRoute();
+            scheduleReroute(path);
+        }
+    }
+}
+
+void DiagramScene::flushReroutes()
+{
+    PerfScope scope("scene.flushReroutes");
+    rerouteScheduled = false;
+    const QSet<DiagramPath *> pending = pendingReroutes;
+    pendingReroutes.clear();
+    if (PerfTrace::enabled)
+        PerfTrace::instance().addCount("reroute.paths", pending.size());
+    for (DiagramPath *path : pending)
+        path->updatePath();
+    refreshConnectorLayer();
+}
+
 void DiagramScene::setLinkVisible(bool b)   //设置全局所有DiagramItem显示连接点
 {
     DiagramItem *item;
@@ -6,9 +6,11 @@
 
 #include "diagramitem.h"
 #include "diagramtextitem.h"
+#include "alignmentindex.h"
 
 #include <QGraphicsScene>
 #include <QKeyEvent>
+#include <QSet>
 
 
 
@@ -42,6 +44,20 @@ public:
     void setItemColor(const QColor &color);
     void setFont(const QFont &font);
     void setLinkVisible(bool b);
+    void setBackgroundTile(const QPixmap &tile);    //网格/线/点背景图块 drawBackground按缩放缓存后平铺
+    void scheduleReroute(DiagramPath *path);    //连线重算请求入队 一帧只算一次
+    void cancelReroute(DiagramPath *path);      //连线被删时撤掉挂起的请求
+    void scheduleObstacleReroutes(const QRectF &movedRect); //避障开启时 图元扫过区域里的连线重新绕行
+    void beginBulkLoad();   //批量导入开始 关掉BSP索引和逐项信号
+    void endBulkLoad();     //批量导入结束 重建一次索引并发sceneLoaded
+    void notifyTextEdited(DiagramTextItem *item);   //文本项失焦时转发textEdited
+    //移动事务 一次捕获整批图元及其连线 拖动中不逐项级联 结束时统一重算
+    void beginMove(const QList<QGraphicsItem *> &selection);
+    void applyMoveDelta(const QPointF &delta);  //整批平移 一次遍历
+    void endMove(bool recordUndo = true);       //一次重算+(可选)一条撤销记录
+    bool moveInProgress() const { return moveActive; }
+    class ConnectorLayer *connectorLayer();     //聚合连线层 首次访问时创建
+    void connectorLayerDestroyed(class ConnectorLayer *layer);  //聚合层被clear()删掉时回调
 
 public slots:
     void setMode(Mode mode);
@@ -54,6 +70,12 @@ signals:
     void textInserted(QGraphicsTextItem *item);
     void itemSelected(QGraphicsItem *item);
     void pathInserted(DiagramPath *path);
+    void itemMoved(QGraphicsItem *item, const QPointF &oldPos);//拖动结束 供撤销引擎记录位移
+    void itemsMoved(const QList<QGraphicsItem *> &items,
+                    const QList<QPointF> &oldPositions);//移动事务结束 整批位移进一条撤销记录
+    void sceneLoaded(); //批量导入完成后只发这一个通知
+    void textRemoved(DiagramTextItem *item);//空文本项失焦待删除 由撤销引擎执行移除
+    void textEdited(DiagramTextItem *item); //标签编辑结束 供全文索引增量更新
 
 protected:
         // 重写键盘事件
@@ -61,10 +83,15 @@ protected:
     void mousePressEvent(QGraphicsSceneMouseEvent *mouseEvent) override;
     void mouseMoveEvent(QGraphicsSceneMouseEvent *mouseEvent) override;
     void mouseReleaseEvent(QGraphicsSceneMouseEvent *mouseEvent) override;
+    void drawBackground(QPainter *painter, const QRectF &rect) override;
     void drawForeground(QPainter *painter, const QRectF &rect) override;
 
 private:
     bool isItemChange(int type) const;
+    void flushReroutes();   //合帧后统一重算挂起的连线
+    void updateBandSelection(const QRectF &newRect);    //框选增量更新 只查新旧矩形的差分条带
+    void refreshConnectorLayer();   //批量重算结束后让聚合层收一次包围盒
+    QRectF guideDamageRect() const; //当前激活辅助线的包围矩形 作为局部重绘脏区
 
     DiagramItem::DiagramType myItemType;
     QMenu *myItemMenu;
@@ -82,6 +109,8 @@ private:
     QPointF endpoint;//鼠标框选末位置
     bool ischeckingbox=false;//判断是否正在框选
     QGraphicsRectItem *rectItem = nullptr;
+    QRectF bandRect;    //上一次事件处理完后的框选矩形 差分基准
+    QSet<QGraphicsItem*> bandSelected;  //当前被框住的图元 离开差分带时逐个取消
 
     QPointF alignPosition;//对齐
     bool isleft = false;     // 标记是否进行水平对齐
@@ -91,7 +120,21 @@ private:
     bool iscenterX = false;   // 标记是否进行中心对齐
     bool iscenterY = false;   // 标记是否进行中心对齐
     QGraphicsItem *movedItem = nullptr;  // 当前正在拖动的图元
+    QPointF movedItemOldPos;  // 拖动开始时的位置 用于撤销记录
+    AlignmentIndex alignIndex;  // 对齐吸附索引 拖动开始时重建一次
+    QSet<DiagramPath*> pendingReroutes; // 本帧内待重算的连线
+    bool rerouteScheduled = false;      // 是否已经约了下一帧的批量重算
     QGraphicsItem *alignedItem = nullptr;  // 当前对齐的图元
+    QRectF lastGuideRect;  // 上一帧辅助线占的窄条 和新帧取并集做脏区
+    QList<DiagramItem*> moveItems;      // 移动事务覆盖的图元
+    QList<QPointF> moveOldPositions;    // 事务开始时各图元的位置
+    QPointF moveLastScenePos;           // 事务中上一次鼠标事件的场景坐标 差分出整批位移
+    QSet<DiagramPath*> movePaths;       // 这批图元关联的连线 去重后结束时各算一次
+    bool moveActive = false;            // 移动事务进行中 itemChange级联被短路
+    class ConnectorLayer *myConnectorLayer = nullptr;   // 聚合连线层 批量绘制开关打开后按需创建
+    QPixmap bgTile;         // 当前背景样式的原始图块
+    QPixmap bgScaledTile;   // 按当前缩放预缩放好的图块 滚动时纯blit
+    qreal bgCachedScale = 0;// bgScaledTile对应的缩放档 变档才重建
     Mode premode;
     QGraphicsLineItem *pathLine;
 };
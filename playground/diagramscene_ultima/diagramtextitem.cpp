@@ -5,6 +5,11 @@
 #include "diagramscene.h"
 #include "diagramitem.h"
 
+#include <QStyleOptionGraphicsItem>
+
+//缩到这个比例以下文字已经看不清 排版也就不用做了
+static const qreal textLodThreshold = 0.4;
+
 //! [0]
 DiagramTextItem::DiagramTextItem(QGraphicsItem *parent)
     : QGraphicsTextItem(parent)
@@ -26,6 +31,16 @@ QVariant DiagramTextItem::itemChange(GraphicsItemChange change,
     return value;
 }
 //! [1]
+void DiagramTextItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option,
+                            QWidget *widget)
+{
+    //远看整张图时跳过富文本排版和绘制 放大回来再正常画
+    const qreal lod = option->levelOfDetailFromTransform(painter->worldTransform());
+    if (lod < textLodThreshold)
+        return;
+    QGraphicsTextItem::paint(painter, option, widget);
+}
+
 void DiagramTextItem::contextMenuEvent(QGraphicsSceneContextMenuEvent *event)
 {
 
@@ -40,6 +55,9 @@ void DiagramTextItem::focusOutEvent(QFocusEvent *event)
 {
     setTextInteractionFlags(Qt::NoTextInteraction);
     emit lostFocus(this);
+    //标签可能是图元的子项 没有连editorLostFocus 这里统一通知场景
+    if (DiagramScene *diagramScene = qobject_cast<DiagramScene *>(scene()))
+        diagramScene->notifyTextEdited(this);
     QGraphicsTextItem::focusOutEvent(event);
 }
 //! [2]
@@ -23,6 +23,8 @@ public:
     DiagramTextItem(QGraphicsItem *parent = nullptr);
 
     int type() const override { return Type; }
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option,
+               QWidget *widget) override;
     QColor text_color;
     // void contextMenuEvent(QGraphicsSceneContextMenuEvent *event);
 
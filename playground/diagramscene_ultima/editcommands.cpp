@@ -0,0 +1,217 @@
+#include "editcommands.h"
+#include "diagramitem.h"
+#include "diagrampath.h"
+#include "diagramscene.h"
+
+/////////////////////////////////// AddItemCommand
+
+AddItemCommand::AddItemCommand(QGraphicsScene *scene, QGraphicsItem *item, QUndoCommand *parent)
+    : QUndoCommand(parent), m_scene(scene), m_item(item), m_inScene(true), m_firstRedo(true)
+{
+    setText(QObject::tr("插入图元"));
+}
+
+AddItemCommand::~AddItemCommand()
+{
+    //undo之后命令被丢弃时 图元不在场景里 由命令负责释放
+    if (!m_inScene)
+        delete m_item;
+}
+
+void AddItemCommand::undo()
+{
+    m_scene->removeItem(m_item);
+    m_inScene = false;
+}
+
+void AddItemCommand::redo()
+{
+    //push时图元已经插入场景 第一次redo不需要重复添加
+    if (m_firstRedo) {
+        m_firstRedo = false;
+        return;
+    }
+    m_scene->addItem(m_item);
+    m_inScene = true;
+}
+
+/////////////////////////////////// AddPathCommand
+
+AddPathCommand::AddPathCommand(QGraphicsScene *scene, DiagramPath *path, QUndoCommand *parent)
+    : QUndoCommand(parent), m_scene(scene), m_path(path), m_inScene(true), m_firstRedo(true)
+{
+    setText(QObject::tr("插入连接线"));
+    const DiagramItem::PathLink *startLink = path->getStartItem()->findLink(path);
+    const DiagramItem::PathLink *endLink = path->getEndItem()->findLink(path);
+    m_startAnchor = startLink != nullptr ? startLink->anchor : 0;
+    m_endAnchor = endLink != nullptr ? endLink->anchor : 0;
+}
+
+AddPathCommand::~AddPathCommand()
+{
+    if (!m_inScene)
+        delete m_path;
+}
+
+void AddPathCommand::undo()
+{
+    //有挂起的合帧重算请求先撤掉 避免flush时访问已摘除的连线
+    if (DiagramScene *diagramScene = qobject_cast<DiagramScene *>(m_scene))
+        diagramScene->cancelReroute(m_path);
+    m_path->getStartItem()->removePath(m_path);
+    m_path->getEndItem()->removePath(m_path);
+    m_scene->removeItem(m_path);
+    m_inScene = false;
+}
+
+void AddPathCommand::redo()
+{
+    if (m_firstRedo) {
+        m_firstRedo = false;
+        return;
+    }
+    m_path->getStartItem()->addLink(m_path, true, m_startAnchor);
+    m_path->getEndItem()->addLink(m_path, false, m_endAnchor);
+    m_scene->addItem(m_path);
+    m_path->updatePath();
+    m_inScene = true;
+}
+
+/////////////////////////////////// MoveItemCommand
+
+MoveItemCommand::MoveItemCommand(QGraphicsItem *item, const QPointF &oldPos,
+                                 const QPointF &newPos, QUndoCommand *parent)
+    : QUndoCommand(parent), m_item(item), m_oldPos(oldPos), m_newPos(newPos)
+{
+    setText(QObject::tr("移动图元"));
+}
+
+void MoveItemCommand::undo()
+{
+    m_item->setPos(m_oldPos);
+}
+
+void MoveItemCommand::redo()
+{
+    m_item->setPos(m_newPos);
+}
+
+/////////////////////////////////// RemoveItemCommand
+
+RemoveItemCommand::RemoveItemCommand(QGraphicsScene *scene, DiagramItem *item, QUndoCommand *parent)
+    : QUndoCommand(parent), m_scene(scene), m_item(item), m_inScene(true)
+{
+    setText(QObject::tr("删除图元"));
+    //先把两端的登记信息记下来 redo时连接线会一起摘掉
+    for (const DiagramItem::PathLink &link : std::as_const(item->links)) {
+        DiagramPath *path = link.path;
+        PathRecord record;
+        record.path = path;
+        record.startItem = path->getStartItem();
+        record.endItem = path->getEndItem();
+        const DiagramItem::PathLink *startLink = record.startItem->findLink(path);
+        const DiagramItem::PathLink *endLink = record.endItem->findLink(path);
+        record.startAnchor = startLink != nullptr ? startLink->anchor : 0;
+        record.endAnchor = endLink != nullptr ? endLink->anchor : 0;
+        m_pathRecords.append(record);
+    }
+}
+
+RemoveItemCommand::~RemoveItemCommand()
+{
+    if (!m_inScene) {
+        for (const PathRecord &record : std::as_const(m_pathRecords))
+            delete record.path;
+        delete m_item;
+    }
+}
+
+void RemoveItemCommand::undo()
+{
+    m_scene->addItem(m_item);
+    for (const PathRecord &record : std::as_const(m_pathRecords)) {
+        record.startItem->addLink(record.path, true, record.startAnchor);
+        record.endItem->addLink(record.path, false, record.endAnchor);
+        m_scene->addItem(record.path);
+        record.path->updatePath();
+    }
+    m_inScene = true;
+}
+
+void RemoveItemCommand::redo()
+{
+    DiagramScene *diagramScene = qobject_cast<DiagramScene *>(m_scene);
+    for (const PathRecord &record : std::as_const(m_pathRecords)) {
+        if (diagramScene != nullptr)
+            diagramScene->cancelReroute(record.path);
+        record.startItem->removePath(record.path);
+        record.endItem->removePath(record.path);
+        if (record.path->scene() == m_scene)
+            m_scene->removeItem(record.path);
+    }
+    m_scene->removeItem(m_item);
+    m_inScene = false;
+}
+
+/////////////////////////////////// RemoveTextCommand
+
+RemoveTextCommand::RemoveTextCommand(QGraphicsScene *scene, QGraphicsItem *item, QUndoCommand *parent)
+    : QUndoCommand(parent), m_scene(scene), m_item(item), m_inScene(true)
+{
+    setText(QObject::tr("删除文本"));
+}
+
+RemoveTextCommand::~RemoveTextCommand()
+{
+    if (!m_inScene)
+        delete m_item;
+}
+
+void RemoveTextCommand::undo()
+{
+    m_scene->addItem(m_item);
+    m_inScene = true;
+}
+
+void RemoveTextCommand::redo()
+{
+    m_scene->removeItem(m_item);
+    m_inScene = false;
+}
+
+/////////////////////////////////// RemovePathCommand
+
+RemovePathCommand::RemovePathCommand(QGraphicsScene *scene, DiagramPath *path, QUndoCommand *parent)
+    : QUndoCommand(parent), m_scene(scene), m_path(path), m_inScene(true)
+{
+    setText(QObject::tr("删除连接线"));
+    const DiagramItem::PathLink *startLink = path->getStartItem()->findLink(path);
+    const DiagramItem::PathLink *endLink = path->getEndItem()->findLink(path);
+    m_startAnchor = startLink != nullptr ? startLink->anchor : 0;
+    m_endAnchor = endLink != nullptr ? endLink->anchor : 0;
+}
+
+RemovePathCommand::~RemovePathCommand()
+{
+    if (!m_inScene)
+        delete m_path;
+}
+
+void RemovePathCommand::undo()
+{
+    m_path->getStartItem()->addLink(m_path, true, m_startAnchor);
+    m_path->getEndItem()->addLink(m_path, false, m_endAnchor);
+    m_scene->addItem(m_path);
+    m_path->updatePath();
+    m_inScene = true;
+}
+
+void RemovePathCommand::redo()
+{
+    if (DiagramScene *diagramScene = qobject_cast<DiagramScene *>(m_scene))
+        diagramScene->cancelReroute(m_path);
+    m_path->getStartItem()->removePath(m_path);
+    m_path->getEndItem()->removePath(m_path);
+    m_scene->removeItem(m_path);
+    m_inScene = false;
+}
@@ -0,0 +1,117 @@
+#ifndef EDITCOMMANDS_H
+#define EDITCOMMANDS_H
+
+#include <QUndoCommand>
+#include <QGraphicsScene>
+#include <QGraphicsItem>
+#include <QPointF>
+#include <QList>
+#include <QString>
+
+class DiagramItem;
+class DiagramPath;
+
+//增量撤销命令 每个命令只记录一次操作的变化量
+//替代原来每次编辑都往 stacks/ 写整个场景快照的方案
+
+//插入图元命令 undo时从场景移除 redo时重新加入
+class AddItemCommand : public QUndoCommand {
+public:
+    AddItemCommand(QGraphicsScene *scene, QGraphicsItem *item, QUndoCommand *parent = nullptr);
+    ~AddItemCommand();
+    void undo() override;
+    void redo() override;
+
+private:
+    QGraphicsScene *m_scene;
+    QGraphicsItem *m_item;
+    bool m_inScene;     //图元当前是否在场景中 决定析构时是否由命令负责释放
+    bool m_firstRedo;   //push时图元已经在场景里 第一次redo不重复添加
+};
+
+//插入连接线命令 undo时同时解除两端item上的登记信息
+class AddPathCommand : public QUndoCommand {
+public:
+    AddPathCommand(QGraphicsScene *scene, DiagramPath *path, QUndoCommand *parent = nullptr);
+    ~AddPathCommand();
+    void undo() override;
+    void redo() override;
+
+private:
+    QGraphicsScene *m_scene;
+    DiagramPath *m_path;
+    quint8 m_startAnchor;   //两端item的登记锚点 undo之后redo时原样恢复
+    quint8 m_endAnchor;
+    bool m_inScene;
+    bool m_firstRedo;
+};
+
+//移动图元命令 只记录新旧坐标
+class MoveItemCommand : public QUndoCommand {
+public:
+    MoveItemCommand(QGraphicsItem *item, const QPointF &oldPos, const QPointF &newPos,
+                    QUndoCommand *parent = nullptr);
+    void undo() override;
+    void redo() override;
+
+private:
+    QGraphicsItem *m_item;
+    QPointF m_oldPos;
+    QPointF m_newPos;
+};
+
+//删除图元命令 记录图元及其连接线 undo时整体恢复
+class RemoveItemCommand : public QUndoCommand {
+public:
+    RemoveItemCommand(QGraphicsScene *scene, DiagramItem *item, QUndoCommand *parent = nullptr);
+    ~RemoveItemCommand();
+    void undo() override;
+    void redo() override;
+
+private:
+    //连接线的恢复信息 两端item和各自的登记锚点
+    struct PathRecord {
+        DiagramPath *path;
+        DiagramItem *startItem;
+        DiagramItem *endItem;
+        quint8 startAnchor;
+        quint8 endAnchor;
+    };
+
+    QGraphicsScene *m_scene;
+    DiagramItem *m_item;
+    QList<PathRecord> m_pathRecords;
+    bool m_inScene;
+};
+
+//删除独立文本项命令 空文本失焦清理也走撤销栈 不再绕过命令系统直接delete
+class RemoveTextCommand : public QUndoCommand {
+public:
+    RemoveTextCommand(QGraphicsScene *scene, QGraphicsItem *item, QUndoCommand *parent = nullptr);
+    ~RemoveTextCommand();
+    void undo() override;
+    void redo() override;
+
+private:
+    QGraphicsScene *m_scene;
+    QGraphicsItem *m_item;
+    bool m_inScene;
+};
+
+//删除连接线命令
+class RemovePathCommand : public QUndoCommand {
+public:
+    RemovePathCommand(QGraphicsScene *scene, DiagramPath *path, QUndoCommand *parent = nullptr);
+    ~RemovePathCommand();
+    void undo() override;
+    void redo() override;
+
+private:
+    QGraphicsScene *m_scene;
+    DiagramPath *m_path;
+    quint8 m_startAnchor;
+    quint8 m_endAnchor;
+    bool m_inScene;
+};
+
+#endif // EDITCOMMANDS_H
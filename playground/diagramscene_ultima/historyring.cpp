@@ -0,0 +1,51 @@
+#include "historyring.h"
+#include <QDebug>
+
+HistoryRing::HistoryRing(qint64 budgetBytes)
+    : budgetBytes(budgetBytes)
+{
+}
+
+void HistoryRing::setBudget(qint64 bytes)
+{
+    budgetBytes = bytes;
+    evictToBudget();
+}
+
+void HistoryRing::push(const QByteArray &snapshot)
+{
+    QByteArray compressed = qCompress(snapshot);
+    //自动保存会在纯视图操作后也触发 内容没变的快照不重复占环
+    if (!entries.isEmpty() && entries.last() == compressed)
+        return;
+    used += compressed.size();
+    entries.append(compressed);
+    evictToBudget();
+}
+
+bool HistoryRing::takeLatest(QByteArray &snapshot)
+{
+    if (entries.isEmpty())
+        return false;
+    const QByteArray compressed = entries.takeLast();
+    used -= compressed.size();
+    snapshot = qUncompress(compressed);
+    if (snapshot.isEmpty()) {
+        qDebug() << "历史快照解压失败";
+        return false;
+    }
+    return true;
+}
+
+void HistoryRing::clear()
+{
+    entries.clear();
+    used = 0;
+}
+
+void HistoryRing::evictToBudget()
+{
+    //至少保留最近一份 否则预算调小后连回滚都没得做
+    while (used > budgetBytes && entries.size() > 1)
+        used -= entries.takeFirst().size();
+}
@@ -0,0 +1,35 @@
+#ifndef HISTORYRING_H
+#define HISTORYRING_H
+
+#include <QByteArray>
+#include <QList>
+
+//压缩的内存历史环
+//每份场景快照压缩后入环 压缩总字节数超预算就从最老的一端丢
+//历史深度只受内存预算约束 完全不碰磁盘 回滚延迟就是一次解压
+class HistoryRing
+{
+public:
+    static const qint64 DefaultBudget = 64 * 1024 * 1024;   //默认64MB
+
+    explicit HistoryRing(qint64 budgetBytes = DefaultBudget);
+
+    void setBudget(qint64 bytes);
+    qint64 budget() const { return budgetBytes; }
+
+    void push(const QByteArray &snapshot);  //压缩入环 和上一份相同则跳过
+    bool takeLatest(QByteArray &snapshot);  //弹出最近一份并解压 环空返回false
+
+    int count() const { return entries.size(); }
+    qint64 usedBytes() const { return used; }
+    void clear();
+
+private:
+    void evictToBudget();   //从最老的一端丢到预算以内
+
+    QList<QByteArray> entries;  //头老尾新 每项是压缩后的快照
+    qint64 budgetBytes;
+    qint64 used = 0;
+};
+
+#endif // HISTORYRING_H
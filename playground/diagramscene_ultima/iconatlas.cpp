@@ -0,0 +1,89 @@
+#include "iconatlas.h"
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QPainter>
+#include <QStandardPaths>
+#include <QDebug>
+
+//形状种类数 枚举是连续的 最后一项是Hexagon
+static const int ShapeCount = DiagramItem::Hexagon + 1;
+
+IconAtlas &IconAtlas::instance()
+{
+    static IconAtlas atlas;
+    return atlas;
+}
+
+QPixmap IconAtlas::icon(DiagramItem::DiagramType type)
+{
+    ensureLoaded();
+    return atlas.copy(int(type) * CellSize, 0, CellSize, CellSize);
+}
+
+//把所有形状预览资源的原始字节过一遍摘要 素材一变哈希就变
+QByteArray IconAtlas::shapeSetHash() const
+{
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    hash.addData(QByteArray::number(AtlasVersion));
+    const QDir iconDir(QStringLiteral(":/images/NodesIcon"));
+    const QStringList entries = iconDir.entryList(QDir::Files, QDir::Name);
+    for (const QString &entry : entries) {
+        QFile file(iconDir.filePath(entry));
+        if (file.open(QIODevice::ReadOnly))
+            hash.addData(file.readAll());
+    }
+    return hash.result().toHex();
+}
+
+QString IconAtlas::cacheFilePath(const QByteArray &hash) const
+{
+    const QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    return cacheDir + QStringLiteral("/toolbox_atlas_") + QString::fromLatin1(hash)
+            + QStringLiteral(".png");
+}
+
+void IconAtlas::ensureLoaded()
+{
+    if (loaded)
+        return;
+    loaded = true;
+
+    const QByteArray hash = shapeSetHash();
+    const QString filePath = cacheFilePath(hash);
+
+    //命中缓存 启动只剩这一次文件读取
+    if (QFile::exists(filePath) && atlas.load(filePath)
+            && atlas.width() == ShapeCount * CellSize && atlas.height() == CellSize) {
+        return;
+    }
+    buildAtlas(filePath);
+}
+
+void IconAtlas::buildAtlas(const QString &filePath)
+{
+    //逐个形状渲染一次 拼成一排 只有首次启动或素材变更才走到这里
+    atlas = QPixmap(ShapeCount * CellSize, CellSize);
+    atlas.fill(Qt::transparent);
+    QPainter painter(&atlas);
+    painter.setRenderHint(QPainter::SmoothPixmapTransform);
+    for (int t = 0; t < ShapeCount; ++t) {
+        DiagramItem item(static_cast<DiagramItem::DiagramType>(t), nullptr);
+        const QPixmap cell = item.image().scaled(CellSize, CellSize, Qt::KeepAspectRatio,
+                                                 Qt::SmoothTransformation);
+        painter.drawPixmap(t * CellSize + (CellSize - cell.width()) / 2,
+                           (CellSize - cell.height()) / 2, cell);
+    }
+    painter.end();
+
+    const QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    QDir dir(cacheDir);
+    dir.mkpath(QStringLiteral("."));
+    //旧哈希的图集顺手清掉 缓存目录不积灰
+    const QStringList stale = dir.entryList({QStringLiteral("toolbox_atlas_*.png")}, QDir::Files);
+    for (const QString &entry : stale)
+        dir.remove(entry);
+
+    if (!atlas.save(filePath))
+        qDebug() << "图标图集写入失败:" << filePath;
+}
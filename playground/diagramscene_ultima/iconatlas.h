@@ -0,0 +1,35 @@
+#ifndef ICONATLAS_H
+#define ICONATLAS_H
+
+#include <QPixmap>
+#include <QByteArray>
+#include <QString>
+#include "diagramitem.h"
+
+//工具箱图元预览的启动图集
+//首次启动把20种形状的预览拼成一张图存到缓存目录 之后每次启动只读这一个文件
+//文件名里带形状资源的哈希 素材一变自动重建 不会用到过期图标
+class IconAtlas
+{
+public:
+    static IconAtlas &instance();
+
+    //取某种形状的预览图 需要时才加载/重建图集
+    QPixmap icon(DiagramItem::DiagramType type);
+
+private:
+    IconAtlas() = default;
+
+    static const int CellSize = 70;     //和工具箱按钮的图标尺寸一致
+    static const int AtlasVersion = 1;  //排版格式变了就改版本号强制重建
+
+    void ensureLoaded();
+    QByteArray shapeSetHash() const;    //所有形状资源字节的摘要
+    QString cacheFilePath(const QByteArray &hash) const;
+    void buildAtlas(const QString &filePath);
+
+    QPixmap atlas;
+    bool loaded = false;
+};
+
+#endif // ICONATLAS_H
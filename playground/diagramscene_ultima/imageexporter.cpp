@@ -0,0 +1,104 @@
+#include "imageexporter.h"
+#include <QGraphicsScene>
+#include <QImageWriter>
+#include <QPainter>
+#include <QTimer>
+#include <QDebug>
+
+void ImageWriteWorker::writeImage(const QImage &image, const QString &fileName)
+{
+    QImageWriter writer(fileName);
+    const bool ok = writer.write(image);
+    if (!ok)
+        qDebug() << "图片写盘失败:" << fileName << writer.errorString();
+    emit writeFinished(ok, fileName);
+}
+
+ImageExporter::ImageExporter(QObject *parent)
+    : QObject(parent)
+{
+    //写盘工没有父对象 整体搬到工作线程上
+    worker = new ImageWriteWorker();
+    worker->moveToThread(&writerThread);
+    connect(&writerThread, &QThread::finished, worker, &QObject::deleteLater);
+    connect(this, &ImageExporter::encodeRequested, worker, &ImageWriteWorker::writeImage);
+    connect(worker, &ImageWriteWorker::writeFinished, this, &ImageExporter::writeDone);
+    writerThread.start();
+}
+
+ImageExporter::~ImageExporter()
+{
+    writerThread.quit();
+    writerThread.wait();
+}
+
+void ImageExporter::start(QGraphicsScene *scene, const QString &fileName, const QSize &targetSize)
+{
+    if (m_busy || scene == nullptr || targetSize.isEmpty())
+        return;
+    m_busy = true;
+    m_cancelRequested = false;
+    m_scene = scene;
+    m_fileName = fileName;
+    m_sceneRect = scene->sceneRect();
+
+    m_image = QImage(targetSize, QImage::Format_ARGB32_Premultiplied);
+    m_image.fill(Qt::white);
+
+    m_bandsDone = 0;
+    m_bandCount = (targetSize.height() + BandHeight - 1) / BandHeight;
+
+    emit progressChanged(0, m_bandCount);
+    QTimer::singleShot(0, this, &ImageExporter::renderNextBand);
+}
+
+void ImageExporter::cancel()
+{
+    m_cancelRequested = true;
+}
+
+void ImageExporter::renderNextBand()
+{
+    if (!m_busy)
+        return;
+    if (m_cancelRequested) {
+        //渲染到一半取消 丢掉已画的条带 不碰磁盘
+        m_image = QImage();
+        m_scene = nullptr;
+        m_busy = false;
+        emit exportCanceled();
+        return;
+    }
+
+    const int y = m_bandsDone * BandHeight;
+    const int h = qMin(BandHeight, m_image.height() - y);
+    //目标条带对应的场景区域 按高度比例映射
+    const qreal sceneYPerPixel = m_sceneRect.height() / m_image.height();
+    const QRectF targetBand(0, y, m_image.width(), h);
+    const QRectF sourceBand(m_sceneRect.left(), m_sceneRect.top() + y * sceneYPerPixel,
+                            m_sceneRect.width(), h * sceneYPerPixel);
+
+    QPainter painter(&m_image);
+    painter.setRenderHint(QPainter::Antialiasing);
+    m_scene->render(&painter, targetBand, sourceBand);
+    painter.end();
+
+    ++m_bandsDone;
+    emit progressChanged(m_bandsDone, m_bandCount);
+
+    if (m_bandsDone >= m_bandCount) {
+        //渲染完 编码和写盘交给工作线程 QImage隐式共享 跨线程传值不拷贝像素
+        m_scene = nullptr;
+        emit encodeRequested(m_image, m_fileName);
+        m_image = QImage();
+        return;
+    }
+    //下一条带排回事件循环 渲染间隙窗口照常响应
+    QTimer::singleShot(0, this, &ImageExporter::renderNextBand);
+}
+
+void ImageExporter::writeDone(bool ok, const QString &fileName)
+{
+    m_busy = false;
+    emit exportFinished(ok, fileName);
+}
@@ -0,0 +1,70 @@
+#ifndef IMAGEEXPORTER_H
+#define IMAGEEXPORTER_H
+
+#include <QObject>
+#include <QThread>
+#include <QImage>
+#include <QRectF>
+#include <QString>
+
+QT_BEGIN_NAMESPACE
+class QGraphicsScene;
+QT_END_NAMESPACE
+
+//工作线程里的编码写盘工 收到整张图后编码并写文件
+//编码(PNG压缩)才是大图导出卡顿的大头 必须离开GUI线程
+class ImageWriteWorker : public QObject
+{
+    Q_OBJECT
+
+public slots:
+    void writeImage(const QImage &image, const QString &fileName);
+
+signals:
+    void writeFinished(bool ok, const QString &fileName);
+};
+
+//离屏导出流水线
+//GUI线程按条带渲染场景 每个条带之间回到事件循环 窗口不再失去响应
+//渲染完成后整张图交给工作线程编码写盘 全程带进度和取消
+class ImageExporter : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ImageExporter(QObject *parent = nullptr);
+    ~ImageExporter();
+
+    bool isBusy() const { return m_busy; }
+    //开始导出 立即返回 结果通过exportFinished/exportCanceled通知
+    void start(QGraphicsScene *scene, const QString &fileName, const QSize &targetSize);
+    void cancel();
+
+signals:
+    void progressChanged(int done, int total);  //已渲染条带数/总条带数
+    void exportFinished(bool ok, const QString &fileName);
+    void exportCanceled();
+    //内部信号 用队列连接把编码任务投递到工作线程
+    void encodeRequested(const QImage &image, const QString &fileName);
+
+private slots:
+    void renderNextBand();  //GUI线程 渲染一个条带后把下一条排回事件循环
+    void writeDone(bool ok, const QString &fileName);
+
+private:
+    static const int BandHeight = 256;  //条带高度 px
+
+    QThread writerThread;
+    ImageWriteWorker *worker;
+
+    QGraphicsScene *m_scene = nullptr;
+    QString m_fileName;
+    QImage m_image;
+    QRectF m_sceneRect;
+    int m_bandsDone = 0;
+    int m_bandCount = 0;
+    bool m_busy = false;
+    bool m_cancelRequested = false;
+};
+
+#endif // IMAGEEXPORTER_H
@@ -1,10 +1,30 @@
-//程序运行开始的地方 -- 运行mainwindow
+//程序运行开始的地方 -- 运行mainwindow 或带--export时走无头批量导出
 #include "mainwindow.h"
+#include "batchexporter.h"
+#include "diagrampath.h"
 #include <QApplication>
 
 int main(int argv, char *args[])
 {
+    //无头导出模式不需要窗口系统 建QApplication前先切offscreen平台
+    //外部已经指定了QT_QPA_PLATFORM时尊重外部设置
+    bool headless = false;
+    for (int i = 1; i < argv; ++i) {
+        if (qstrcmp(args[i], "--export") == 0)
+            headless = true;
+    }
+    if (headless && !qEnvironmentVariableIsSet("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    //聚合连线层默认开启 必须在建任何场景之前设置
+    //之后挂进场景的连线都登记到ConnectorLayer 一次paint画完整层
+    DiagramPath::setBatchedRendering(true);
+
     QApplication app(argv, args);
+
+    if (headless)
+        return BatchExporter::run(app.arguments());
+
     MainWindow mainWindow;
     // mainWindow.setGeometry(0, 0, 1920,1080);
     // mainWindow.show();
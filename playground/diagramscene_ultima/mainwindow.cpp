@@ -6,8 +6,18 @@
 #include "diagramtextitem.h"
 #include "mainwindow.h"
 #include "deletecommand.h"
+#include "editcommands.h"
+#include "projectrecords.h"
+#include "binaryprojectfile.h"
+#include "autosavemanager.h"
+#include "imageexporter.h"
+#include "perftrace.h"
+#include "mygraphicsview.h"
+#include "iconatlas.h"
+#include "minimapwidget.h"
 #include "diagramitemgroup.h"
 #include "diagrampath.h"
+#include <QUndoStack>
 
 #include <QtWidgets>
 
@@ -24,6 +34,7 @@
 #include <QList>
 #include <QPlainTextEdit>
 #include <QTextStream>
+#include "projectloader.h"
 
 #include <QSvgGenerator>
 #include <QGraphicsScene>
@@ -73,7 +84,7 @@ MainWindow::MainWindow()
 
     scene = new DiagramScene(itemMenu, this);
     scene->setSceneRect(QRectF(0, 0, 1920, 1080)); // 设置新场景的矩形区域
-    scene->setBackgroundBrush(QPixmap(":/images/background4.png")); //默认纯白 我选的灰白网格
+    scene->setBackgroundTile(QPixmap(":/images/background4.png")); //默认纯白 我选的灰白网格
 
 
     //信号和槽 主要是组件被选择后的信号
@@ -84,16 +95,53 @@ MainWindow::MainWindow()
     connect(findReplaceDialog, &FindReplaceDialog::findText, this, &MainWindow::handleFindText);
     connect(findReplaceDialog, &FindReplaceDialog::replaceText, this, &MainWindow::handleReplaceText);
     connect(findReplaceDialog, &FindReplaceDialog::replaceAllText, this, &MainWindow::handleReplaceAllText);
-    connect(scene, &DiagramScene::itemInserted,this, &MainWindow::savefilestack);
-    connect(scene, &DiagramScene::textInserted,this, &MainWindow::savefilestack);
-    connect(scene, &DiagramScene::pathInserted,this, &MainWindow::savefilestack);
+
+    //撤销引擎 每次编辑只往内存里压一个增量命令 不再整场景写盘
+    //每个标签页一个栈 undoStack始终指向当前标签页的
+    undoStack = undoStackFor(scene);
+    connect(scene, &DiagramScene::itemInserted,this, &MainWindow::recordItemInserted);
+    connect(scene, &DiagramScene::textInserted,this, &MainWindow::recordTextInserted);
+    connect(scene, &DiagramScene::pathInserted,this, &MainWindow::recordPathInserted);
+    connect(scene, &DiagramScene::itemMoved,this, &MainWindow::recordItemMoved);
+    connect(scene, &DiagramScene::itemsMoved,this, &MainWindow::recordItemsMoved);
+    connect(scene, &DiagramScene::textRemoved,this, &MainWindow::recordTextRemoved);
+
+    //自动保存 编辑后延迟一秒做快照 写盘全在工作线程 UI不等QFile
+    autosaveManager = new AutosaveManager();
+    autosaveTimer = new QTimer(this);
+    autosaveTimer->setSingleShot(true);
+    autosaveTimer->setInterval(1000);
+    connect(autosaveTimer, &QTimer::timeout, this, &MainWindow::performAutosave);
+    connect(scene, &DiagramScene::itemInserted,this, &MainWindow::scheduleAutosave);
+    connect(scene, &DiagramScene::textInserted,this, &MainWindow::scheduleAutosave);
+    connect(scene, &DiagramScene::pathInserted,this, &MainWindow::scheduleAutosave);
+    connect(scene, &DiagramScene::itemMoved,this, &MainWindow::scheduleAutosave);
+    connect(scene, &DiagramScene::itemsMoved,this, &MainWindow::scheduleAutosave);
+    connect(scene, &DiagramScene::textEdited,this, &MainWindow::updateTextIndex);
+
+    //后台标签页休眠巡检 闲置的场景压成快照释放活对象
+    hibernateTimer = new QTimer(this);
+    hibernateTimer->setInterval(60 * 1000);
+    connect(hibernateTimer, &QTimer::timeout, this, &MainWindow::hibernateIdleTabs);
+    hibernateTimer->start();
+    sceneLastActive[scene] = QDateTime::currentMSecsSinceEpoch();
+
+    //离屏图片导出 条带渲染不冻结窗口 编码写盘在工作线程
+    imageExporter = new ImageExporter(this);
+    connect(imageExporter, &ImageExporter::progressChanged, this, &MainWindow::exportProgressChanged);
+    connect(imageExporter, &ImageExporter::exportFinished, this, &MainWindow::exportDone);
+    connect(imageExporter, &ImageExporter::exportCanceled, this, &MainWindow::exportAborted);
 
 
     ///////////////////////////////////
     //这一段不建议进行注释处理 不认可能会导致内存报错 整个程序不能再构建
     layout = new QHBoxLayout;
     layout->addWidget(toolBox);
-    view = new QGraphicsView(scene);
+    //换成带性能HUD的视图 F12开关叠加层 右键菜单仍走CustomContextMenu信号
+    MyGraphicsView *hudView = new MyGraphicsView(this);
+    hudView->setScene(scene);
+    hudView->setCacheMode(QGraphicsView::CacheBackground);  //背景缓存在视口里 平移时直接搬移
+    view = hudView;
     view->setContextMenuPolicy(Qt::CustomContextMenu);
     connect(view, &QGraphicsView::customContextMenuRequested, this, &MainWindow::showContextMenu);
     //这一段不建议进行注释处理 不认可能会导致内存报错 整个程序不能再构建
@@ -120,6 +168,14 @@ MainWindow::MainWindow()
     widget->setLayout(layout);
 
     setCentralWidget(widget);
+
+    //导航小地图 降采样缓存增量刷新 拖视口框平移主视图
+    minimap = new MinimapWidget(this);
+    QDockWidget *minimapDock = new QDockWidget(tr("导航图"), this);
+    minimapDock->setWidget(minimap);
+    minimapDock->setAllowedAreas(Qt::LeftDockWidgetArea | Qt::RightDockWidgetArea);
+    addDockWidget(Qt::RightDockWidgetArea, minimapDock);
+    minimap->setTarget(scene, view);
     QIcon icon(":/images/logo.png");
     // QIcon icon(":/images/logo.ico");
     if (!icon.isNull()) {
@@ -142,75 +198,16 @@ MainWindow::MainWindow()
     connect(tabwidget, &QTabWidget::tabCloseRequested, this, &MainWindow::closeScene);
 }
 
+MainWindow::~MainWindow()
+{
+    //自动保存对象在工作线程上 不能挂父对象 手动收掉(析构会等线程退出)
+    delete autosaveManager;
+}
 
-// void MainWindow::undo() {
-//     if (!undoStack->isEmpty()) {
-//         QString stateFilePath = undoStack.pop();
-//         loadState(stateFilePath);
-//         redoStack.push(stateFilePath);
-//     }
-// }
-
-// void MainWindow::redo() {
-//     if (!redoStack.isEmpty()) {
-//         QString stateFilePath = redoStack.pop();
-//         loadState(stateFilePath);
-//         undoStack.push(stateFilePath);
-//     }
-// }
 
 QString saveFilePath;//全局变量 文件路径 用来实现文件便利读取
 QString key = "123";
 
-// DiagramItem 和 LineSegment 结构体的定义
-struct  WriteDiagramItem {
-    int x; // x坐标
-    int y; // y坐标
-    int width; // 宽度
-    int height; // 高度
-    int type; // 图形类型
-    int rbg[4]; // 图形颜色(rbg三原色+透明度)
-    QString internalText; // 图形内部Text的内容
-    int itemtype;// 图形的类型
-    QString texttype;// 图形内部文本的类型
-    int textsize;//文字字号
-    bool boldtype;//是否黑体
-    bool itlatic;//是否斜体
-    int textrbg[4];// 图形内部文字的color
-};
-
-struct ReadDiagramItem {
-    int x; // x坐标
-    int y; // y坐标
-    int width; // 宽度
-    int height; // 高度
-    int type; // 图形类型
-    int rbg[4]; // 图形颜色(rbg三原色+透明度)
-    QString internalText; // 图形内部Text的内容
-    int itemtype;// 图形的类型
-    QString texttype;// 图形内部文本的类型
-    int textsize;//文字字号
-    bool boldtype;//是否黑体
-    bool itlatic;//是否斜体
-    int textrbg[4];// 图形内部文字的color
-};
-
-struct WriteDiagramPath
-{
-    int start;//开始item编号
-    int startp;//开始item节点
-    int end;//结束item编号
-    int endp;//结束item节点
-};
-
-struct ReadDiagramPath
-{
-    int start;//开始item编号
-    int startp;//开始item节点
-    int end;//结束item编号
-    int endp;//结束item节点
-};
-
 
 
 
@@ -259,77 +256,15 @@ void MainWindow::savefile(){
     saveFilePath = textFile;
     // 保存 saveFilePath 到文件
     saveSaveFilePath(saveFilePath);
-    // 创建 QFile 对象
-    QFile file(textFile);
-    // 以只写模式打开文件
-    if (!file.open(QIODevice::WriteOnly)) {
-        QMessageBox::critical(this, tr("保存失败"), tr("无法打开或写入工程信息."));
-        saveFileSuccess = false;
-        return;
-    }
-    // 创建 QTextStream 对象，并指定编码为 UTF-8
-    QTextStream out(&file);
-    // 获取 DiagramItem 结构体指针列表
+    // 获取 DiagramItem 和 DiagramPath 结构体指针列表
     QList<WriteDiagramItem*> diagramItems = getStructList();  //这个是得到的图形的
-    // 写入 DiagramItem 结构体列表的大小
-    out << "DT_Size_" << diagramItems.size() << "\n";
-    // 遍历 DiagramItem 结构体指针列表
-    for (WriteDiagramItem* itemPtr : diagramItems) {
-        // 替换 internalText 和 texttype 中的空格为星号
-        QString modifiedInternalText = itemPtr->internalText.replace(" ", "*");
-        QString modifiedTextType = itemPtr->texttype.replace(" ", "*");
-
-        // 写入结构体成员
-        out << itemPtr->x << " "
-            << itemPtr->y << " "
-            << itemPtr->width << " "
-            << itemPtr->height << " "
-            << itemPtr->type << " ";
-        for (int i = 0; i < 4; ++i) {
-            out << itemPtr->rbg[i] << " ";
-        }
-        out << modifiedInternalText << " " // 使用替换后的 internalText
-            << itemPtr->itemtype << " "
-            << modifiedTextType << " " // 使用替换后的 texttype
-            << itemPtr->textsize << " "
-            << itemPtr->boldtype << " "
-            << itemPtr->itlatic << " ";
-        for (int i = 0; i < 4; ++i) {
-            out << itemPtr->textrbg[i] << " ";
-        }
-        out << "\n";
-    }
-    // 关闭文件
-    file.close();
-    // 获取 DiagramPath 结构体指针列表
-    // 获取 DiagramPath 结构体指针列表
     QList<struct WriteDiagramPath *> diagramPathsPtrs = getStructList1();
-    // 如果用户取消了文件选择或列表为空，则不执行任何操作
-    if (textFile.isEmpty() || diagramPathsPtrs.isEmpty()) {
-        saveFileSuccess = false;
-        return;
-    }
-    // 以追加模式打开文件，以写入 DiagramPath 数据
-    if (!file.open(QIODevice::Append)) {
+    // 以二进制格式写入 定长记录加字符串表 不再需要把空格换成星号
+    if (!BinaryProjectFile::save(textFile, diagramItems, diagramPathsPtrs)) {
         QMessageBox::critical(this, tr("保存失败"), tr("无法打开或写入工程信息."));
         saveFileSuccess = false;
         return;
     }
-    // 写入 DiagramPath 结构体列表的大小
-    out << "LN_Size_" << diagramPathsPtrs.size() << "\n";
-
-    // 遍历 DiagramPath 结构体指针列表
-    for (struct WriteDiagramPath *pathPtr : diagramPathsPtrs) {
-        if (pathPtr) {
-            // 写入结构体成员
-            out << pathPtr->start << " "
-                << pathPtr->startp << " "
-                << pathPtr->end << " "
-                << pathPtr->endp << "\n";
-        }
-    }
-    // 关闭文件
-    file.close();
 }
 ///////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////
@@ -345,141 +280,27 @@ void MainWindow::loadfile() {
         return;
     }
 
-    // 创建 QFile 对象
-    QFile file(textFile);
-    // 以只读模式打开文件
-    if (file.open(QIODevice::ReadOnly)) {
-        // 创建 QTextStream 对象
-        QTextStream in(&file);
+    // 创建新的列表用于存放读取的数据
+    QList<ReadDiagramItem> readDiagramItems;
+    QList<ReadDiagramPath> readDiagramPaths;
 
-        // 创建新的列表用于存放读取的数据
-        QList<ReadDiagramItem> readDiagramItems;
-
-        // 读取 DiagramItem 结构体列表的大小
-        QString sizeString;
-        in >> sizeString;
-        if (sizeString.startsWith("DT_Size_")) {
-            quint32 diagramItemCount = sizeString.mid(8).toUInt(); // 去掉前缀并转换为整数
-            for (quint32 i = 0; i < diagramItemCount; ++i) {
-                ReadDiagramItem item;
-                in >> item.x >> item.y >> item.width >> item.height >> item.type;
-                for (int j = 0; j < 4; ++j) {
-                    in >> item.rbg[j];
-                }
-                // 读取 internalText 并替换星号为空格
-                QString internalText;
-                in >> internalText;
-                item.internalText = internalText.replace("*", " ");
-                in >> item.itemtype;
-                // 读取 texttype 并替换星号为空格
-                QString textType;
-                in >> textType;
-                item.texttype = textType.replace("*", " ");
-                in >> item.textsize;
-                // 读取布尔值需要特殊处理
-                QString boldTypeStr;
-                in >> boldTypeStr;
-                item.boldtype = (boldTypeStr == "true");
-
-                QString itlaticStr;
-                in >> itlaticStr;
-                item.itlatic = (itlaticStr == "true");
-
-                for (int j = 0; j < 4; ++j) {
-                    in >> item.textrbg[j];
-                }
-                // 调试输出每个读取到的 DiagramItem
-                qDebug() << "Read DiagramItem:";
-                qDebug() << "x: " << item.x;
-                qDebug() << "y: " << item.y;
-                qDebug() << "width: " << item.width;
-                qDebug() << "height: " << item.height;
-                qDebug() << "type: " << item.type;
-                qDebug() << "rbg: ";
-                for (int i = 0; i < 4; ++i) {
-                    qDebug() << item.rbg[i];
-                }
-                qDebug() << "internalText: " << item.internalText;
-                qDebug() << "itemtype: " << item.itemtype;
-                qDebug() << "texttype: " << item.texttype;
-                qDebug() << "textsize: " << item.textsize;
-                qDebug() << "boldtype: " << item.boldtype;
-                qDebug() << "itlatic: " << item.itlatic;
-                qDebug() << "textrbg: ";
-                for (int i = 0; i < 4; ++i) {
-                    qDebug() << item.textrbg[i];
-                }
-                readDiagramItems.append(item);
-            }
-        }
-
-        // 创建新的列表用于存放读取的 DiagramPath 数据
-        QList<ReadDiagramPath> readDiagramPaths;
-        in >> sizeString;
-        if (sizeString.startsWith("LN_Size_")) {
-            quint32 diagramPathCount = sizeString.mid(8).toUInt(); // 去掉前缀并转换为整数
-            for (quint32 i = 0; i < diagramPathCount; ++i) {
-                ReadDiagramPath path;
-                in >> path.start >> path.startp >> path.end >> path.endp;
-                // 调试输出每个读取到的 DiagramPath
-                qDebug() << "Read DiagramPath:";
-                qDebug() << "start: " << path.start;
-                qDebug() << "startp: " << path.startp;
-                qDebug() << "end: " << path.end;
-                qDebug() << "endp: " << path.endp;
-                readDiagramPaths.append(path);
-            }
-        }
-        newScene();
-        QList<DiagramItem*> DiagramItemList;
-        foreach (ReadDiagramItem item,readDiagramItems) {
-            qDebug()<<"画";
-            DiagramItem *item1=new DiagramItem(static_cast<DiagramItem::DiagramType>(item.itemtype),itemMenu);
-            item1->setPos(QPoint(item.x,item.y));
-            item1->setFixedSize(QSize(item.width,item.height));
-            QColor itemcolor(item.rbg[0],item.rbg[2],item.rbg[1],item.rbg[3]);
-            QColor textcolor(item.textrbg[0],item.textrbg[2],item.textrbg[1],item.textrbg[3]);
-            item1->m_color=itemcolor;
-            item1->textItem->setPlainText(item.internalText);
-            item1->textItem->font().setPointSize(item.textsize);
-            item1->textItem->font().setFamily(item.texttype);
-            item1->textItem->font().setBold(item.boldtype);
-            item1->textItem->font().setItalic(item.itlatic);
-            item1->textItem->setDefaultTextColor(textcolor);
-            scene->addItem(item1);
-            DiagramItemList.append(item1);
-        }
-
-        int size = DiagramItemList.size();
-        qDebug()<<"size: "<< size;
-        foreach (ReadDiagramPath item,readDiagramPaths) {
-            DiagramItem *startItem = DiagramItemList.at(item.start-1 );
-            DiagramItem *endItem = DiagramItemList.at(item.end-1 );
-            qDebug()<<scene->items();
-            DiagramItem::TransformState startState = static_cast<DiagramItem::TransformState>(item.startp);
-            DiagramItem::TransformState endState = static_cast<DiagramItem::TransformState>(item.endp);
-
-            DiagramPath *item1=new DiagramPath(startItem,endItem,startState,endState);
-
-            startItem->addPathes(item1);
-            startItem->marks[item1] = "1" + QString::number(startState);
-            qDebug()<<startItem->marks;
-            endItem->addPathes(item1);
-            endItem->marks[item1] = "0" + QString::number(endState);
-            qDebug()<<endItem->marks;
-            qDebug()<<startState<<endState;
-            item1->updatePath();
-            item1->setZValue(-1000.0);
-
-            scene->addItem(item1);
-
-        }
-        // 提示用户读取成功
-        QMessageBox::information(this, tr("加载完成"), tr("成功加载工程."));
-    } else {
-        // 文件打开失败，提示用户错误信息
+    // 二进制/旧文本格式的选择和解析都在ProjectLoader里 无头导出走同一条路
+    if (!ProjectLoader::loadProject(textFile, readDiagramItems, readDiagramPaths)) {
         QMessageBox::critical(this, tr("加载失败"), tr("无法打开或读取文件信息."));
+        return;
     }
+
+    newScene();
+    populateScene(readDiagramItems, readDiagramPaths);
+    // 提示用户读取成功
+    QMessageBox::information(this, tr("加载完成"), tr("成功加载工程."));
+}
+
+//按读取记录批量重建当前场景 loadfile和快照回滚共用
+void MainWindow::populateScene(const QList<struct ReadDiagramItem> &readDiagramItems,
+                               const QList<struct ReadDiagramPath> &readDiagramPaths)
+{
+    ProjectLoader::populateScene(scene, itemMenu, readDiagramItems, readDiagramPaths);
 }
 
 ///////////////////////////////////////////////////////////////////
@@ -487,6 +308,8 @@ void MainWindow::loadfile() {
 ///////////////////////////////////////////////////////////////////
 QList<struct WriteDiagramItem *> MainWindow::getStructList() {
     QList<struct WriteDiagramItem *> DiagramItemList;
+    //记录从池里拿 上一轮快照的对象直接复用 不再每次new且无人释放
+    writeItemPool.reset();
     int p=0;
     foreach(QGraphicsItem *item, scene->items()) {
         DiagramItem *item1 = qgraphicsitem_cast<DiagramItem *>(item);
@@ -495,7 +318,7 @@ QList<struct WriteDiagramItem *> MainWindow::getStructList() {
             qWarning() << "Failed to cast item to DiagramItem";
             continue;
         }
-        struct WriteDiagramItem *item0 = new WriteDiagramItem();
+        struct WriteDiagramItem *item0 = writeItemPool.take();
         p++;
         item0->x = item1->pos().x();
         item0->y = item1->pos().y();
@@ -505,33 +328,43 @@ QList<struct WriteDiagramItem *> MainWindow::getStructList() {
         item0->rbg[1] = item1->m_color.blue();
         item0->rbg[2] = item1->m_color.green();
         item0->rbg[3] = item1->m_color.alpha();
-        item0->internalText = item1->textItem->toPlainText();
+        const QFont labelFont = item1->labelFont();
+        const QColor labelColor = item1->labelColor();
+        item0->internalText = item1->labelText();
         item0->itemtype = item1->myDiagramType;
-        item0->texttype = item1->textItem->font().family();
-        item0->textsize = item1->textItem->font().pointSize();
-        item0->boldtype = item1->textItem->font().bold();
-        item0->itlatic = item1->textItem->font().italic();
-        item0->textrbg[0] = item1->textItem->defaultTextColor().red();
-        item0->textrbg[1] = item1->textItem->defaultTextColor().blue();
-        item0->textrbg[2] = item1->textItem->defaultTextColor().green();
-        item0->textrbg[3] = item1->textItem->defaultTextColor().alpha();
-        qDebug()<<"type:"<<item1->myDiagramType;
-        qDebug()<<"item_marks: "<<item1->marks;
-
-        foreach (DiagramPath* line, item1->pathes) {
-            if(item1->marks[line][0] == '1' ){
+        item0->texttype = labelFont.family();
+        item0->textsize = labelFont.pointSize();
+        item0->boldtype = labelFont.bold();
+        item0->itlatic = labelFont.italic();
+        item0->textrbg[0] = labelColor.red();
+        item0->textrbg[1] = labelColor.blue();
+        item0->textrbg[2] = labelColor.green();
+        item0->textrbg[3] = labelColor.alpha();
+        //逐项日志本身就有可观耗时 默认关掉 排查时打开PerfTrace::verboseLog
+        if (PerfTrace::verboseLog) {
+            qDebug()<<"type:"<<item1->myDiagramType;
+            qDebug()<<"item_links: "<<item1->links.size();
+        }
+
+        for (const DiagramItem::PathLink &link : std::as_const(item1->links)) {
+            DiagramPath *line = link.path;
+            if(link.isStart){
                 line->start = p;
-                line->startp = item1->marks[line][1].digitValue();
-                qDebug()<<line;
-                qDebug()<<"start:"<<line->start;
-                qDebug()<<"startp"<<line->startp;
+                line->startp = link.anchor;
+                if (PerfTrace::verboseLog) {
+                    qDebug()<<line;
+                    qDebug()<<"start:"<<line->start;
+                    qDebug()<<"startp"<<line->startp;
+                }
             }
-            else if(item1->marks[line][0] == '0'){
+            else{
                 line->end = p;
-                line->endp = item1->marks[line][1].digitValue();
-                qDebug()<<line;
-                qDebug()<<"end:"<<line->end;
-                qDebug()<<"endp"<<line->endp;
+                line->endp = link.anchor;
+                if (PerfTrace::verboseLog) {
+                    qDebug()<<line;
+                    qDebug()<<"end:"<<line->end;
+                    qDebug()<<"endp"<<line->endp;
+                }
             }
         }
 
@@ -542,29 +375,233 @@ QList<struct WriteDiagramItem *> MainWindow::getStructList() {
 /////////////////////////////////////
 QList<struct WriteDiagramPath *> MainWindow::getStructList1() {
     QList<struct WriteDiagramPath *> DiagramItemList;
+    writePathPool.reset();
     foreach(QGraphicsItem *item, scene->items()) {
         DiagramPath *item1 = qgraphicsitem_cast<DiagramPath *>(item);
         if (!item1) {
             // 如果没有成功转换，可能是类型不匹配，可以在这里添加一个警告
             continue;
         }
-        struct WriteDiagramPath *item0 = new WriteDiagramPath();
+        struct WriteDiagramPath *item0 = writePathPool.take();
         item0->start=item1->start;
         item0->startp=item1->startp;
         item0->end=item1->end;
         item0->endp=item1->endp;
-        qDebug()<<"load path: ";
-        qDebug()<<"start: "<<item0->start;
-        qDebug()<<"startp:"<<item0->startp;
-        qDebug()<<"end: "<<item0->end;
-        qDebug()<<"endp: "<<item0->endp;
+        if (PerfTrace::verboseLog) {
+            qDebug()<<"load path: ";
+            qDebug()<<"start: "<<item0->start;
+            qDebug()<<"startp:"<<item0->startp;
+            qDebug()<<"end: "<<item0->end;
+            qDebug()<<"endp: "<<item0->endp;
+        }
         DiagramItemList.append(item0);
     }
     return DiagramItemList;
 }
+//自动保存
+///////////////////////////////////////////////////////////////////
+void MainWindow::scheduleAutosave() {
+    //连续编辑只会不停重置计时 停手一秒后才真正做快照
+    autosaveTimer->start();
+}
+
+void MainWindow::performAutosave() {
+    //还没有确定工程路径时存到固定的恢复文件 有路径时存到旁路文件不覆盖正式工程
+    QString target = saveFilePath.isEmpty() ? QString("autosave.fcproj")
+                                            : saveFilePath + ".autosave";
+    QList<WriteDiagramItem> items;
+    QList<WriteDiagramPath> paths;
+    snapshotScene(scene, items, paths);
+    //同一份快照顺手压进内存历史环 回滚不依赖磁盘
+    historyRing.push(BinaryProjectFile::serialize(items, paths));
+    //提交后立即返回 序列化和写盘都在AutosaveManager的工作线程里
+    autosaveManager->submitSnapshot(target, items, paths);
+}
+
+//回滚到历史环里最近一份和当前不同的快照 整场景替换 增量撤销栈随之作废
+void MainWindow::rollbackSnapshot()
+{
+    //自动保存在每次编辑1秒后就把当前状态压进了环 环顶多半和现状一模一样
+    //跳过和当前序列化状态相同的快照 第一次回滚就真的往回走一步
+    QList<WriteDiagramItem> currentItems;
+    QList<WriteDiagramPath> currentPaths;
+    snapshotScene(scene, currentItems, currentPaths);
+    const QByteArray current = BinaryProjectFile::serialize(currentItems, currentPaths);
+
+    QByteArray snapshot;
+    bool found = false;
+    while (historyRing.takeLatest(snapshot)) {
+        if (snapshot != current) {
+            found = true;
+            break;
+        }
+    }
+    if (!found) {
+        QMessageBox::information(this, tr("提示"), tr("没有可回滚的内存快照。"));
+        return;
+    }
+    QList<ReadDiagramItem> readDiagramItems;
+    QList<ReadDiagramPath> readDiagramPaths;
+    if (!BinaryProjectFile::deserialize(snapshot, readDiagramItems, readDiagramPaths)) {
+        QMessageBox::warning(this, tr("错误"), tr("快照数据已损坏。"));
+        return;
+    }
+    undoStack->clear();
+    purgeTextIndex(scene);
+    scene->clear();
+    populateScene(readDiagramItems, readDiagramPaths);
+}
+
+//避障开关 翻转后全局路由代号变了 所有缓存失效
+//现有连线立刻入队重算 不用等端点移动才换绕法
+void MainWindow::toggleObstacleAvoidance(bool enabled)
+{
+    DiagramPath::setObstacleAvoidance(enabled);
+    foreach (QGraphicsItem *item, scene->items()) {
+        if (DiagramPath *path = qgraphicsitem_cast<DiagramPath *>(item))
+            scene->scheduleReroute(path);
+    }
+}
+
+//场景即将整体拆除(休眠/回滚/关标签页) 把里面的文本项从全文索引摘干净
+//不摘的话索引攥着野指针 新项复用同一地址时textOf()会给出前任的文本
+void MainWindow::purgeTextIndex(DiagramScene *targetScene)
+{
+    foreach (QGraphicsItem *item, targetScene->items()) {
+        if (DiagramTextItem *textItem = qgraphicsitem_cast<DiagramTextItem *>(item))
+            textIndex.removeItem(textItem);
+    }
+}
+
+//为自动保存做值快照 编号规则和getStructList保持一致 但不在堆上分配也不打日志
+void MainWindow::snapshotScene(DiagramScene *targetScene,
+                               QList<WriteDiagramItem> &items, QList<WriteDiagramPath> &paths) {
+    PerfScope scope("main.snapshotScene");
+    int p=0;
+    foreach(QGraphicsItem *item, targetScene->items()) {
+        DiagramItem *item1 = qgraphicsitem_cast<DiagramItem *>(item);
+        if (!item1) {
+            continue;
+        }
+        WriteDiagramItem item0;
+        p++;
+        item0.x = item1->pos().x();
+        item0.y = item1->pos().y();
+        item0.width = item1->boundingRect().width()*0.8;
+        item0.height = item1->boundingRect().height()*0.72;
+        item0.rbg[0] = item1->m_color.red();
+        item0.rbg[1] = item1->m_color.blue();
+        item0.rbg[2] = item1->m_color.green();
+        item0.rbg[3] = item1->m_color.alpha();
+        const QFont labelFont = item1->labelFont();
+        const QColor labelColor = item1->labelColor();
+        item0.internalText = item1->labelText();
+        item0.itemtype = item1->myDiagramType;
+        item0.texttype = labelFont.family();
+        item0.textsize = labelFont.pointSize();
+        item0.boldtype = labelFont.bold();
+        item0.itlatic = labelFont.italic();
+        item0.textrbg[0] = labelColor.red();
+        item0.textrbg[1] = labelColor.blue();
+        item0.textrbg[2] = labelColor.green();
+        item0.textrbg[3] = labelColor.alpha();
+
+        for (const DiagramItem::PathLink &link : std::as_const(item1->links)) {
+            DiagramPath *line = link.path;
+            if(link.isStart){
+                line->start = p;
+                line->startp = link.anchor;
+            }
+            else{
+                line->end = p;
+                line->endp = link.anchor;
+            }
+        }
+
+        items.append(item0);
+    }
+    foreach(QGraphicsItem *item, targetScene->items()) {
+        DiagramPath *path = qgraphicsitem_cast<DiagramPath *>(item);
+        if (!path) {
+            continue;
+        }
+        WriteDiagramPath record;
+        record.start = path->start;
+        record.startp = path->startp;
+        record.end = path->end;
+        record.endp = path->endp;
+        paths.append(record);
+    }
+}
+
+//后台标签页闲置超过这个时长就休眠 巡检周期取其一半
+static const qint64 HibernateIdleMs = 2 * 60 * 1000;
+
+void MainWindow::hibernateIdleTabs()
+{
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    const int currentIndex = tabwidget->currentIndex();
+    for (int i = 0; i < sceneVector.size(); ++i) {
+        DiagramScene *backgroundScene = sceneVector.at(i);
+        if (i == currentIndex || hibernatedScenes.contains(backgroundScene))
+            continue;
+        if (backgroundScene->items().isEmpty())
+            continue;   //空场景没什么可省的
+        if (now - sceneLastActive.value(backgroundScene, now) < HibernateIdleMs)
+            continue;
+
+        //压缩快照留底 然后拆掉所有活对象 文本编辑器/索引/悬停跟踪一并释放
+        QList<WriteDiagramItem> items;
+        QList<WriteDiagramPath> paths;
+        snapshotScene(backgroundScene, items, paths);
+        hibernatedScenes[backgroundScene] = qCompress(BinaryProjectFile::serialize(items, paths));
+
+        //这个标签页自己的撤销栈里还攥着它的图元指针 只作废它这一个栈
+        //当前标签页的历史不受影响
+        if (QUndoStack *backgroundStack = undoStacks.value(backgroundScene))
+            backgroundStack->clear();
+        purgeTextIndex(backgroundScene);
+        backgroundScene->beginBulkLoad();
+        backgroundScene->clear();
+        backgroundScene->endBulkLoad();
+        qDebug() << "标签页" << i << "已休眠 压缩快照"
+                 << hibernatedScenes[backgroundScene].size() / 1024 << "KB";
+    }
+    updateTabMemoryInfo();
+}
+
+//激活休眠标签页 解压快照走批量导入路径重建
+void MainWindow::wakeScene(DiagramScene *targetScene)
+{
+    const QByteArray snapshot = qUncompress(hibernatedScenes.take(targetScene));
+    QList<ReadDiagramItem> readDiagramItems;
+    QList<ReadDiagramPath> readDiagramPaths;
+    if (!BinaryProjectFile::deserialize(snapshot, readDiagramItems, readDiagramPaths)) {
+        qDebug() << "休眠快照损坏 无法恢复";
+        return;
+    }
+    populateScene(readDiagramItems, readDiagramPaths);
+}
+
+//每个标签页的提示里写清它现在占的是活对象还是压缩快照
+void MainWindow::updateTabMemoryInfo()
+{
+    for (int i = 0; i < sceneVector.size() && i < tabwidget->count(); ++i) {
+        DiagramScene *tabScene = sceneVector.at(i);
+        if (hibernatedScenes.contains(tabScene)) {
+            tabwidget->setTabToolTip(i, tr("已休眠 压缩快照 %1 KB")
+                                     .arg(hibernatedScenes.value(tabScene).size() / 1024));
+        } else {
+            tabwidget->setTabToolTip(i, tr("活跃 %1 个对象").arg(tabScene->items().size()));
+        }
+    }
+}
+
 //组合
 void MainWindow::combination(){
     DiagramItemGroup *group = new DiagramItemGroup();
+    //入组时的批量重定位走移动事务 不逐项触发itemChange级联
+    scene->beginMove(scene->selectedItems());
     foreach (QGraphicsItem *item, scene->selectedItems()) {
         DiagramItem *item1 = qgraphicsitem_cast<DiagramItem *>(item);
         if(item1){
@@ -573,6 +610,7 @@ void MainWindow::combination(){
             scene->removeItem(item);
         }
     }
+    scene->endMove(false);  //组合不是位移 不进撤销栈
     scene->addItem(group);
     scene->update();
     group->setPos(group->getTopLeft());
@@ -583,6 +621,8 @@ void MainWindow::cancelCombination(){
     DiagramItemGroup *group = qgraphicsitem_cast<DiagramItemGroup *>(scene->selectedItems().first());
     if(group){
         scene->removeItem(scene->selectedItems().first());
+        //拆组时的批量回位同样走移动事务 结束后连线统一重算一遍
+        scene->beginMove(group->childItems());
         for(int t=0;group->childItems().size()>0;t++) {
             DiagramItem *item1 = qgraphicsitem_cast<DiagramItem *>(group->childItems().at(0));
             if(item1){
@@ -591,6 +631,7 @@ void MainWindow::cancelCombination(){
                 item1->ableEvents();
             }
         }
+        scene->endMove(false);  //回位是拆组的一部分 不单独进撤销栈
         scene->update();
     }
 }
@@ -601,12 +642,30 @@ void MainWindow::openFindReplaceDialog()
         findReplaceDialog->show();  // 显示查找和替换对话框
     }
 }
+//索引只认DiagramTextItem 标签模式的图元对它不可见
+//查找前扫一遍 把文字命中的标签就地提升 之后走正常索引流程
+void MainWindow::promoteMatchingLabels(const QString &needle)
+{
+    if (needle.isEmpty())
+        return;
+    foreach (QGraphicsItem *item, scene->items()) {
+        if (DiagramItem *diagramItem = qgraphicsitem_cast<DiagramItem *>(item)) {
+            if (diagramItem->textItem == nullptr && diagramItem->labelText().contains(needle))
+                diagramItem->promoteLabel();
+        }
+    }
+}
+
 void MainWindow::handleFindText(const QString &text)
 {
     bool found = false;  // 用于指示是否找到文本
+    promoteMatchingLabels(text);
     QList<QGraphicsItem *> items = scene->items();  // 获取场景中的所有文本项
     int startIndex = 0;  // 从哪个文本项开始查找
 
+    //先问索引要含有该文本的项 下面的循环只在这些项上做定位
+    const QSet<DiagramTextItem *> matchSet = textIndex.matches(text, items);
+
     // 如果上次已经查找到某个文本框了，继续从该文本框及其后面的文本框开始查找
     if (currentTextItem) {
         // 取消当前高亮
@@ -620,7 +679,9 @@ void MainWindow::handleFindText(const QString &text)
     // 从当前文本框的下一个字符开始继续查找
     for (int i = startIndex; i < items.size(); ++i) {
         if (DiagramTextItem *textItem = qgraphicsitem_cast<DiagramTextItem *>(items[i])) {
-            QString content = textItem->toPlainText();  // 获取文本内容
+            if (!matchSet.contains(textItem))
+                continue;   //索引说没有 跳过 不再materialize内容
+            QString content = textIndex.textOf(textItem);  // 缓存内容 不再toPlainText
 
             // 如果是从当前文本项继续查找，使用 lastSearchPosition 来避免从头查找
             int searchStartPosition = (textItem == currentTextItem) ? lastSearchPosition + 1 : 0;
@@ -656,29 +717,38 @@ void MainWindow::handleFindText(const QString &text)
 
 void MainWindow::handleReplaceText(const QString &findText, const QString &replaceText)
 {
-    // 遍历场景中的所有文本项，替换指定文本
+    // 替换第一个匹配项 候选由索引给出 只碰命中的文本项
+    promoteMatchingLabels(findText);
+    const QSet<DiagramTextItem *> matchSet = textIndex.matches(findText, scene->items());
     foreach (QGraphicsItem *item, scene->items()) {
         if (DiagramTextItem *textItem = qgraphicsitem_cast<DiagramTextItem *>(item)) {
-            QString currentText = textItem->toPlainText();
-            if (currentText.contains(findText)) {
-                textItem->setPlainText(currentText.replace(findText, replaceText));  // 替换找到的文本
-                break;  // 替换第一个匹配项后退出循环
-            }
+            if (!matchSet.contains(textItem))
+                continue;
+            QString currentText = textIndex.textOf(textItem);
+            textItem->setPlainText(currentText.replace(findText, replaceText));  // 替换找到的文本
+            textIndex.updateItem(textItem, currentText);    // 索引跟着改
+            break;  // 替换第一个匹配项后退出循环
         }
     }
 }
 
 void MainWindow::handleReplaceAllText(const QString &findText, const QString &replaceText)
 {
-    // 遍历场景中的所有文本项，替换所有匹配的文本
-    foreach (QGraphicsItem *item, scene->items()) {
-        if (DiagramTextItem *textItem = qgraphicsitem_cast<DiagramTextItem *>(item)) {
-            QString currentText = textItem->toPlainText();
-            if (currentText.contains(findText)) {
-                textItem->setPlainText(currentText.replace(findText, replaceText));  // 替换所有匹配项
-            }
-        }
+    // 一遍替换所有匹配项 不命中的项完全不碰 最后统一刷新一次
+    promoteMatchingLabels(findText);
+    const QSet<DiagramTextItem *> matchSet = textIndex.matches(findText, scene->items());
+    foreach (DiagramTextItem *textItem, matchSet) {
+        QString currentText = textIndex.textOf(textItem);
+        textItem->setPlainText(currentText.replace(findText, replaceText));  // 替换所有匹配项
+        textIndex.updateItem(textItem, currentText);
     }
+    scene->update();
+}
+
+//标签编辑结束 只重建这一项的索引条目
+void MainWindow::updateTextIndex(DiagramTextItem *item)
+{
+    textIndex.updateItem(item, item->toPlainText());
 }
 
 //! [0]
@@ -689,10 +759,21 @@ void MainWindow::sceneChanged() // 新加
     if (currentIndex >= 0 && currentIndex < sceneVector.size()) {
         scene = sceneVector[currentIndex];
         view = viewVector[currentIndex];
+        //撤销引擎跟着标签页切 新标签页首次切到时建栈
+        undoStack = undoStackFor(scene);
         // 重新连接信号和槽
         connect(scene, &DiagramScene::itemInserted, this, &MainWindow::itemInserted);
         connect(scene, &DiagramScene::textInserted, this, &MainWindow::textInserted);
         connect(scene, &DiagramScene::itemSelected, this, &MainWindow::itemSelected);
+
+        //切回休眠的标签页时按压缩快照懒恢复
+        sceneLastActive[scene] = QDateTime::currentMSecsSinceEpoch();
+        if (hibernatedScenes.contains(scene))
+            wakeScene(scene);
+        updateTabMemoryInfo();
+
+        //小地图跟着当前标签页走
+        minimap->setTarget(scene, view);
     }
 }
 //画布菜单
@@ -729,170 +810,189 @@ void MainWindow::showContextMenu(const QPoint &pos) {
 }
 //复制
 void MainWindow::copyItems() {
-    QByteArray itemData;
-    QDataStream dataStream(&itemData, QIODevice::WriteOnly);
+    //选区只取一次 用QSet做端点归属判断 避免在QList上反复contains
+    const QList<QGraphicsItem *> selectedItems = scene->selectedItems();
+    const QSet<QGraphicsItem *> selectedSet(selectedItems.begin(), selectedItems.end());
+
+    //整个选区写进同一个预留好容量的缓冲 头部记数量 粘贴按数量读取
+    QByteArray batchData;
+    batchData.reserve(selectedItems.size() * 128);
+    QDataStream dataStream(&batchData, QIODevice::WriteOnly);
+
     QMap<DiagramItem*,int> idmap;
+    qint32 itemCount = 0;
+    qint32 pathCount = 0;
+    foreach (QGraphicsItem *item, selectedItems) {
+        if (dynamic_cast<DiagramItem*>(item)) {
+            ++itemCount;
+        } else if (DiagramPath *path = dynamic_cast<DiagramPath*>(item)) {
+            if (selectedSet.contains(path->getStartItem()) &&
+                selectedSet.contains(path->getEndItem()))
+                ++pathCount;
+        }
+    }
+
+    dataStream << itemCount;
     int p = 0;
-    foreach (QGraphicsItem *item, scene->selectedItems()) {
+    foreach (QGraphicsItem *item, selectedItems) {
         if (DiagramItem *diagramItem = dynamic_cast<DiagramItem*>(item)) {
             QPointF itemPos = diagramItem->pos(); // 获取图形项的位置
             QColor itemColor = diagramItem->m_color; // 获取图形项的颜色
             QSizeF itemSize = diagramItem->boundingRect().size(); // 获取图形项的大小
-            QString content =  diagramItem->textItem->toPlainText();
-            QColor textColor = diagramItem->textItem->defaultTextColor();
-            QFont font =diagramItem->textItem->font();
+            QString content =  diagramItem->labelText();
+            QColor textColor = diagramItem->labelColor();
+            QFont font =diagramItem->labelFont();
             idmap[diagramItem] = p; //item的编号
             dataStream << static_cast<int>(diagramItem->myDiagramType)
                        << itemPos.x() << itemPos.y()
                        << itemColor.rgba() // 颜色以RGBA形式存储
                        << itemSize.width() << itemSize.height() << content <<textColor
                        <<font<<p++; // 存储大小
-            // QMimeData *mimeData = new QMimeData();
-            // mimeData->setData("application/x-diagramscene-item-type", itemData);
-            // QApplication::clipboard()->setMimeData(mimeData, QClipboard::Clipboard);
-            qDebug() << "复制成功";
         }
     }
 
-    QByteArray pathData;
-    QDataStream pathStream(&pathData,QIODevice::WriteOnly);
-
-    foreach (QGraphicsItem *item, scene->selectedItems()) {
+    //两端都在选区里的连线跟着走 端点编号重映射成选区内的序号
+    dataStream << pathCount;
+    foreach (QGraphicsItem *item, selectedItems) {
         if(DiagramPath *path = dynamic_cast<DiagramPath*>(item)){
-            if(scene->selectedItems().contains(path->getStartItem()) &&
-                scene->selectedItems().contains(path->getEndItem())){
+            if(selectedSet.contains(path->getStartItem()) &&
+                selectedSet.contains(path->getEndItem())){
                 int start = idmap[path->getStartItem()];
                 int end = idmap[path->getEndItem()];
-                QChar startc = path->getStartItem()->marks[path][1];
-                QChar endc = path->getEndItem()->marks[path][1];
-                int startp = startc.digitValue();
-                int endp = endc.digitValue();
-                pathStream<<start<<end<<startp<<endp;
-                // QMimeData *mimeData = new QMimeData();
-                // mimeData->setData("application/x-digramscene-path-type",itemData);
-                // QApplication::clipboard()->setMimeData(mimeData,QClipboard::Clipboard);
-                qDebug()<<"线复制成功";
+                int startp = path->getStartItem()->findLink(path)->anchor;
+                int endp = path->getEndItem()->findLink(path)->anchor;
+                dataStream<<start<<end<<startp<<endp;
             }
         }
     }
+    qDebug() << "复制成功" << itemCount << pathCount;
 
     QMimeData *mimeData = new QMimeData();
-    mimeData->setData("application/x-diagramscene-item-type",itemData);
-    mimeData->setData("application/x-digramscene-path-type",pathData);
+    mimeData->setData("application/x-diagramscene-batch-type",batchData);
     QApplication::clipboard()->setMimeData(mimeData,QClipboard::Clipboard);
 
 }
 
 void MainWindow::cutItems() {
-    QByteArray itemData;
-    QDataStream dataStream(&itemData, QIODevice::WriteOnly);
-
-    QList<QGraphicsItem*> itemsToCut; // 用于存储要剪切的图形项
+    //剪切=复制+删除 序列化格式和copyItems共用一套 不再维护两份写入代码
+    copyItems();
 
+    QList<DiagramItem*> itemsToCut; // 用于存储要剪切的图形项
     foreach (QGraphicsItem *item, scene->selectedItems()) {
-        if (DiagramItem *diagramItem = dynamic_cast<DiagramItem*>(item)) {
-            QPointF itemPos = diagramItem->pos(); // 获取图形项的位置
-            QColor itemColor = diagramItem->m_color; // 获取图形项的颜色
-            QSizeF itemSize = diagramItem->boundingRect().size(); // 获取图形项的大小
-            QString content =  diagramItem->textItem->toPlainText();
-            QColor textColor = diagramItem->textItem->defaultTextColor();
-            QFont font =diagramItem->textItem->font();
-
-            dataStream << static_cast<int>(diagramItem->myDiagramType)
-                       << itemPos.x() << itemPos.y()
-                       << itemColor.rgba() // 颜色以RGBA形式存储
-                       << itemSize.width() << itemSize.height() << content <<textColor<<font; // 存储大小
-
-            itemsToCut.append(item); // 将图形项添加到剪切列表
-            QMimeData *mimeData = new QMimeData();
-            mimeData->setData("application/x-diagramscene-item-type", itemData);
-            QApplication::clipboard()->setMimeData(mimeData, QClipboard::Clipboard);
-            qDebug() << "剪切成功";
+        if (DiagramItem *item1 = qgraphicsitem_cast<DiagramItem *>(item)) {
+            itemsToCut.append(item1);
         }
     }
-    foreach (QGraphicsItem *item, itemsToCut) {
-        scene->removeItem(item);
-        delete item;
+    if (itemsToCut.isEmpty())
+        return;
+    //删除走和deleteItem相同的命令通道 栈里的旧命令不会留下悬空指针
+    //整次剪切合成一条撤销记录 Ctrl+Z一次恢复全部图元和连线
+    undoStack->beginMacro(tr("剪切"));
+    foreach (DiagramItem *item1, itemsToCut) {
+        item1->removeArrows();
+        undoStack->push(new RemoveItemCommand(scene, item1));
     }
-
+    undoStack->endMacro();
+    qDebug() << "剪切成功";
 }
 
 void MainWindow::pasteItems(const QPointF &scenePos) {
     QMap<int,DiagramItem*> idmap;
     const QMimeData *mimeData = QApplication::clipboard()->mimeData();
-    if (mimeData && mimeData->hasFormat("application/x-diagramscene-item-type")) {
-        qDebug()<<"enter item paste";
-        QByteArray itemData = mimeData->data("application/x-diagramscene-item-type");
-        QDataStream dataStream(&itemData, QIODevice::ReadOnly);
-        QPointF firstItemOffset;
-        bool isFirstItem = true;
-        while (!dataStream.atEnd()) {
-            int typeInt;
-            qreal x, y;
-            quint32 color;
-            qreal width, height;
-            QString str;
-            QColor textcolor;
-            QFont font;
-            int id;
-            dataStream >> typeInt >> x >> y >> color >> width >> height>>str>>textcolor>>font>>id;
-
-            QGraphicsItem *newItem = scene->createItem(typeInt); // 直接使用读取的位置
-
-            if (DiagramItem *newDiagramItem = dynamic_cast<DiagramItem*>(newItem)) {
-                QColor itemColor = QColor(color); // 从RGBA值创建QColor对象
-                QSizeF itemSize(width*0.8, height*0.72); // 创建大小
-
-                newDiagramItem->setBrush(itemColor); // 设置颜色
-                newDiagramItem->setFixedSize(itemSize); // 设置固定大小
-                newDiagramItem->textItem->setPlainText(str);//设置文字
-                newDiagramItem->textItem->setDefaultTextColor(textcolor);
-                newDiagramItem->textItem->setFont(font);
-
-                idmap[id] = newDiagramItem;
-
-                if (isFirstItem) {
-                    firstItemOffset = QPointF(x, y);
-                    newDiagramItem->setPos(scenePos);
-                    isFirstItem = false;
-                } else {
-                    QPointF offset = QPointF(x, y) - firstItemOffset;
-                    newDiagramItem->setPos(scenePos + offset);
-                }
+    if (!mimeData || !mimeData->hasFormat("application/x-diagramscene-batch-type")) {
+        qDebug()<<"have no batch-type";
+        return;
+    }
 
-                scene->addItem(newItem);
-            }
-        }
-        qDebug()<<"add item finished";
-    }
-
-    if(mimeData->hasFormat("application/x-digramscene-path-type")){
-        qDebug()<<"enter path paste";
-        QByteArray pathData = mimeData->data("application/x-digramscene-path-type");
-        QDataStream dataStream(&pathData,QIODevice::ReadOnly);
-        while(!dataStream.atEnd()){
-            int start;
-            int end;
-            int startp;
-            int endp;
-            dataStream>>start>>end>>startp>>endp;
-            DiagramItem *startItem = idmap[start];
-            DiagramItem *endItem = idmap[end];
-            DiagramItem::TransformState startState = static_cast<DiagramItem::TransformState>(startp);
-            DiagramItem::TransformState endState = static_cast<DiagramItem::TransformState>(endp);
-
-            DiagramPath *path = new DiagramPath(startItem,endItem,startState,endState);
-            startItem->addPathes(path);
-            startItem->marks[path] = "1" + QString::number(startp);
-            endItem->addPathes(path);
-            endItem->marks[path] = "0" + QString::number(endp);
-            path->updatePath();
-            path->setZValue(-1000.0);
-            scene->addItem(path);
+    QByteArray batchData = mimeData->data("application/x-diagramscene-batch-type");
+    QDataStream dataStream(&batchData, QIODevice::ReadOnly);
+
+    //先把所有对象构造好 再走批量插入 整个粘贴是一次场景事务
+    qint32 itemCount = 0;
+    dataStream >> itemCount;
+    QList<DiagramItem*> newItems;
+    QPointF firstItemOffset;
+    bool isFirstItem = true;
+    for (qint32 i = 0; i < itemCount; ++i) {
+        int typeInt;
+        qreal x, y;
+        quint32 color;
+        qreal width, height;
+        QString str;
+        QColor textcolor;
+        QFont font;
+        int id;
+        dataStream >> typeInt >> x >> y >> color >> width >> height>>str>>textcolor>>font>>id;
+
+        DiagramItem *newDiagramItem = new DiagramItem(
+            static_cast<DiagramItem::DiagramType>(typeInt), itemMenu);
+        QColor itemColor = QColor(color); // 从RGBA值创建QColor对象
+        QSizeF itemSize(width*0.8, height*0.72); // 创建大小
+
+        newDiagramItem->setBrush(itemColor); // 设置颜色
+        newDiagramItem->setFixedSize(itemSize); // 设置固定大小
+        newDiagramItem->setLabelText(str);//设置文字
+        newDiagramItem->setLabelColor(textcolor);
+        newDiagramItem->setLabelFont(font);
+
+        idmap[id] = newDiagramItem;
+
+        if (isFirstItem) {
+            firstItemOffset = QPointF(x, y);
+            newDiagramItem->setPos(scenePos);
+            isFirstItem = false;
+        } else {
+            QPointF offset = QPointF(x, y) - firstItemOffset;
+            newDiagramItem->setPos(scenePos + offset);
         }
-    }else{
-        qDebug()<<"have no path-type";
+        newItems.append(newDiagramItem);
+    }
+
+    qint32 pathCount = 0;
+    dataStream >> pathCount;
+    QList<DiagramPath*> newPaths;
+    for (qint32 i = 0; i < pathCount; ++i) {
+        int start;
+        int end;
+        int startp;
+        int endp;
+        dataStream>>start>>end>>startp>>endp;
+        DiagramItem *startItem = idmap[start];
+        DiagramItem *endItem = idmap[end];
+        DiagramItem::TransformState startState = static_cast<DiagramItem::TransformState>(startp);
+        DiagramItem::TransformState endState = static_cast<DiagramItem::TransformState>(endp);
+
+        DiagramPath *path = new DiagramPath(startItem,endItem,startState,endState);
+        startItem->addLink(path, true, quint8(startp));
+        endItem->addLink(path, false, quint8(endp));
+        path->updatePath();
+        path->setZValue(-1000.0);
+        newPaths.append(path);
     }
+
+    //批量插入 索引和信号挂起 结束时一次性恢复
+    scene->beginBulkLoad();
+    foreach (DiagramItem *item, newItems) {
+        scene->addItem(item);
+    }
+    foreach (DiagramPath *path, newPaths) {
+        scene->addItem(path);
+    }
+    scene->endBulkLoad();
+
+    //整次粘贴只压一条撤销记录 子命令挂在同一个父命令下
+    QUndoCommand *pasteCommand = new QUndoCommand(tr("粘贴"));
+    foreach (DiagramItem *item, newItems) {
+        new AddItemCommand(scene, item, pasteCommand);
+    }
+    foreach (DiagramPath *path, newPaths) {
+        new AddPathCommand(scene, path, pasteCommand);
+    }
+    undoStack->push(pasteCommand);
+
+    //快照也只做一次
+    scheduleAutosave();
+    qDebug()<<"粘贴完成"<<itemCount<<pathCount;
 }
 
 
@@ -916,16 +1016,58 @@ bool MainWindow::saveSceneAsImage() {
         savePicPath = fileName;
         // 保存 saveFilePath 到文件
         saveSavePicPath(savePicPath);
-        QPixmap pixmap = view->grab(); // 使用视图的grab方法
-        if (!pixmap.save(fileName)) {
-            QMessageBox::warning(this, tr("Error"), tr("Unable to save the image."));
-        } else {
-            QMessageBox::information(this, tr("Success"), tr("Image saved successfully."));
-        }
+        startImageExport(fileName); // 交给离屏导出流水线 结果异步弹窗
     }
     return true;
 }
 
+//整幅场景交给离屏导出流水线 按条带渲染 编码写盘在工作线程
+void MainWindow::startImageExport(const QString &fileName)
+{
+    if (imageExporter->isBusy()) {
+        QMessageBox::information(this, tr("提示"), tr("已有导出任务正在进行中。"));
+        return;
+    }
+
+    exportProgress = new QProgressDialog(tr("正在导出图片..."), tr("取消"), 0, 1, this);
+    exportProgress->setWindowModality(Qt::WindowModal);
+    exportProgress->setMinimumDuration(300);    //小场景导出很快 不闪进度条
+    connect(exportProgress, &QProgressDialog::canceled, imageExporter, &ImageExporter::cancel);
+
+    imageExporter->start(scene, fileName, scene->sceneRect().size().toSize());
+}
+
+void MainWindow::exportProgressChanged(int done, int total)
+{
+    if (exportProgress != nullptr) {
+        exportProgress->setMaximum(total);
+        exportProgress->setValue(done);
+    }
+}
+
+void MainWindow::exportDone(bool ok, const QString &fileName)
+{
+    if (exportProgress != nullptr) {
+        exportProgress->deleteLater();
+        exportProgress = nullptr;
+    }
+    if (!ok) {
+        QMessageBox::warning(this, tr("Error"), tr("Unable to save the image."));
+    } else {
+        QMessageBox::information(this, tr("Success"), tr("Image saved successfully."));
+        qDebug() << "图片导出完成:" << fileName;
+    }
+}
+
+void MainWindow::exportAborted()
+{
+    if (exportProgress != nullptr) {
+        exportProgress->deleteLater();
+        exportProgress = nullptr;
+    }
+    qDebug() << "图片导出已取消";
+}
+
 //关闭提示
 void MainWindow::closeEvent(QCloseEvent *event) {
     QMessageBox messageBox(QMessageBox::Warning, tr("工程文件未保存"), tr("是否保存工程文件？"),
@@ -962,13 +1104,13 @@ void MainWindow::backgroundButtonGroupClicked(QAbstractButton *button)
     }
     QString text = button->text();
     if (text == tr("Blue Grid"))
-        scene->setBackgroundBrush(QPixmap(":/images/background1.png"));
+        scene->setBackgroundTile(QPixmap(":/images/background1.png"));
     else if (text == tr("White Grid"))
-        scene->setBackgroundBrush(QPixmap(":/images/background2.png"));
+        scene->setBackgroundTile(QPixmap(":/images/background2.png"));
     else if (text == tr("Gray Grid"))
-        scene->setBackgroundBrush(QPixmap(":/images/background3.png"));
+        scene->setBackgroundTile(QPixmap(":/images/background3.png"));
     else
-        scene->setBackgroundBrush(QPixmap(":/images/background4.png"));
+        scene->setBackgroundTile(QPixmap(":/images/background4.png"));
 
     scene->update();
     view->update();
@@ -1007,31 +1149,34 @@ void MainWindow::deleteItem()
             delete item;
         }
     }
+    //整个选区的删除合成一条撤销记录 和粘贴/群移的粒度保持一致
+    bool macroOpen = false;
     selectedItems = scene->selectedItems();
     for (QGraphicsItem *item : std::as_const(selectedItems)) {
         if (item->type() == DiagramItem::Type){
             DiagramItem *item1 = qgraphicsitem_cast<DiagramItem *>(item);
             item1->removeArrows();
-            item1->removePathes();
-            // savefilestack();
-            scene->removeItem(item1);
-            // savefilestack();
-            delete item1;
+            if (!macroOpen) {
+                undoStack->beginMacro(tr("删除"));
+                macroOpen = true;
+            }
+            //删除命令记录图元和连接线的增量 undo时整体恢复
+            undoStack->push(new RemoveItemCommand(scene, item1));
         }
     }
     selectedItems = scene->selectedItems();
     for (QGraphicsItem *item : std::as_const(selectedItems)) {
         if (item->type() == DiagramPath::Type) {
-            // qDebug()<<"asd1";
-            savefilestack();
-            scene->removeItem(item);
-            savefilestack();
             DiagramPath *path = qgraphicsitem_cast<DiagramPath *>(item);
-            path->getStartItem()->removePath(path);
-            path->getEndItem()->removePath(path);
-            delete item;
+            if (!macroOpen) {
+                undoStack->beginMacro(tr("删除"));
+                macroOpen = true;
+            }
+            undoStack->push(new RemovePathCommand(scene, path));
         }
     }
+    if (macroOpen)
+        undoStack->endMacro();
 }
 //! [3]
 
@@ -1189,10 +1334,12 @@ void MainWindow::newScene() // 新加
     // 创建新的场景和视图
     DiagramScene *newScene = new DiagramScene(itemMenu, this);
     newScene->setSceneRect(QRectF(0, 0, 1920, 1080)); // 设置新场景的矩形区域
-    newScene->setBackgroundBrush(QPixmap(":/images/background4.png")); // 设置背景
+    newScene->setBackgroundTile(QPixmap(":/images/background4.png")); // 设置背景
 
     // 创建新的视图并关联到新场景
-    QGraphicsView *newView = new QGraphicsView(newScene);
+    MyGraphicsView *newView = new MyGraphicsView(this);
+    newView->setScene(newScene);
+    newView->setCacheMode(QGraphicsView::CacheBackground);  //背景缓存在视口里 平移时直接搬移
     newView->setRenderHint(QPainter::Antialiasing); // 设置抗锯齿，提高渲染质量
 
     // 设置视图中心，使其与场景的左上角对齐
@@ -1210,6 +1357,9 @@ void MainWindow::newScene() // 新加
     connect(newScene, &DiagramScene::itemInserted, this, &MainWindow::itemInserted);
     connect(newScene, &DiagramScene::textInserted, this, &MainWindow::textInserted);
     connect(newScene, &DiagramScene::itemSelected, this, &MainWindow::itemSelected);
+    connect(newScene, &DiagramScene::textEdited, this, &MainWindow::updateTextIndex);
+    connect(newScene, &DiagramScene::textRemoved, this, &MainWindow::recordTextRemoved);
+    sceneLastActive[newScene] = QDateTime::currentMSecsSinceEpoch();
 
     // 通知主窗口场景已改变
     sceneChanged();
@@ -1239,6 +1389,11 @@ void MainWindow::closeScene(int index)  // 新加
     disconnect(sceneToRemove, &DiagramScene::itemInserted, this, &MainWindow::itemInserted);
     disconnect(sceneToRemove, &DiagramScene::textInserted, this, &MainWindow::textInserted);
     disconnect(sceneToRemove, &DiagramScene::itemSelected, this, &MainWindow::itemSelected);
+    // 休眠快照/活跃时间戳/撤销栈/全文索引一并清理
+    purgeTextIndex(sceneToRemove);
+    hibernatedScenes.remove(sceneToRemove);
+    sceneLastActive.remove(sceneToRemove);
+    delete undoStacks.take(sceneToRemove);
     // 从向量中移除场景和视图
     sceneVector.removeAt(index);
     viewVector.removeAt(index);
@@ -1356,13 +1511,8 @@ bool MainWindow::saveSceneAsImageOrSvg() {
                 QMessageBox::information(this, tr("Success"), tr("SVG saved successfully."));
             }
         } else {
-            QPixmap pixmap = view->grab();
-            if (!pixmap.save(fileName)) {
-                QMessageBox::warning(this, tr("Error"), tr("Unable to save the image."));
-                return false;
-            } else {
-                QMessageBox::information(this, tr("Success"), tr("Image saved successfully."));
-            }
+            // 位图导出交给离屏流水线 SVG是矢量直写不需要条带化
+            startImageExport(fileName);
         }
     }
     return true;
@@ -1497,6 +1647,15 @@ void MainWindow::createActions()
     redoAction->setStatusTip(tr("Redo the last operation"));
     connect(redoAction, &QAction::triggered, this, &MainWindow::redo);
 
+    rollbackAction = new QAction(tr("&回滚快照"), this);
+    rollbackAction->setStatusTip(tr("回滚到内存历史环里最近一份场景快照"));
+    connect(rollbackAction, &QAction::triggered, this, &MainWindow::rollbackSnapshot);
+
+    avoidanceAction = new QAction(tr("&连线避障"), this);
+    avoidanceAction->setCheckable(true);
+    avoidanceAction->setStatusTip(tr("连线绕开路径上的其他图元"));
+    connect(avoidanceAction, &QAction::toggled, this, &MainWindow::toggleObstacleAvoidance);
+
 
 }
 
@@ -1529,6 +1688,8 @@ void MainWindow::createMenus()
     itemMenu->addAction(cutAction);
     itemMenu->addAction(undoAction);
     itemMenu->addAction(redoAction);
+    itemMenu->addAction(rollbackAction);
+    itemMenu->addAction(avoidanceAction);
 
 
     aboutMenu = menuBar()->addMenu(tr("&帮助"));
@@ -1541,7 +1702,7 @@ void MainWindow::createMenus()
 void MainWindow::backgroundChanged(int index)
 {
     QString imagePath = backgroundComboBox->itemData(index).toString();
-    scene->setBackgroundBrush(QPixmap(imagePath));
+    scene->setBackgroundTile(QPixmap(imagePath));
     scene->update();
     view->update();
 }
@@ -1667,9 +1828,8 @@ QWidget *MainWindow::createBackgroundCellWidget(const QString &text, const QStri
 //这个挺重要的 这个主要涉及到了除了文字之外的 左侧菜单栏所有图形
 QWidget *MainWindow::createCellWidget(const QString &text, DiagramItem::DiagramType type)
 {
-
-    DiagramItem item(type, itemMenu);
-    QIcon icon(item.image());
+    //预览图从启动图集里取 不再为每个按钮构造一次性图元并解码250x250素材
+    QIcon icon(IconAtlas::instance().icon(type));
 
     QToolButton *button = new QToolButton;
     button->setIcon(icon);
@@ -1703,267 +1863,64 @@ QIcon MainWindow::createColorIcon(QColor color)
     return QIcon(pixmap);
 }
 //! [32]
+//每个标签页一个撤销栈 命令只引用自己场景里的图元
+//休眠或关闭一个标签页时只动它自己的栈 别的标签页的历史不受牵连
+QUndoStack *MainWindow::undoStackFor(DiagramScene *targetScene)
+{
+    QUndoStack *&stack = undoStacks[targetScene];
+    if (stack == nullptr) {
+        stack = new QUndoStack(this);
+        stack->setUndoLimit(100);
+    }
+    return stack;
+}
+
+//撤销只回退一条命令 O(本次变化量) 不再重读重建整个场景
 void MainWindow::undo() {
-    if (!undoStack.isEmpty()) {
-        QString stateFilePath = undoStack.pop();
-        if(stateFilePath == "0.fcproj") return;
-        loadfilestack(undoStack.top());
-        redoStack.push(stateFilePath);
+    if (undoStack->canUndo()) {
+        undoStack->undo();
     }else{
         qDebug()<<"kongde";
     }
 }
 
 void MainWindow::redo() {
-    if (!redoStack.isEmpty()) {
-        QString stateFilePath = redoStack.pop();
-        loadfilestack(stateFilePath);
-        undoStack.push(stateFilePath);
-    }
-}
-
-void MainWindow::autoCleanStack() {
-    const int maxFiles = 20;  // 设置最大文件数量
-    QDir dir("stacks");
-    QStringList files = dir.entryList(QStringList() << "*.fcproj", QDir::Files);
-    QStack<QString> temporarystack;
-    if (files.size() >= maxFiles) {
-        // 清空栈或删除文件
-        while (files.size() > maxFiles-2) {  // 保留一定数量的文件
-            QString filePath = dir.filePath(files.first());
-            QFile::remove(filePath);
-            files.removeFirst();
-            fileCount--;  // 更新文件计数
-        }
-        while (!undoStack.isEmpty() && undoStack.size() > maxFiles - 2) {
-            QString s = undoStack.pop();
-            temporarystack.push(s);
-        }
-
-        undoStack.clear();
-        while (!temporarystack.isEmpty()) {
-            QString s = temporarystack.pop();
-            undoStack.push(s);
-        }
+    if (undoStack->canRedo()) {
+        undoStack->redo();
     }
 }
 
-//保存文件
-QString MainWindow::savefilestack(){
-
-    QString currentDir = QDir::currentPath();
-    qDebug()<<currentDir;
-    // 创建 undo 文件夹路径
-    QString defaultPath = QDir(currentDir).filePath("stacks");
-    QString textFile = QString::number(path) +".fcproj";
-    QDir dir(defaultPath);
-    if (!dir.exists()) {
-        dir.mkpath(".");
-    }
-    QString filePath = dir.filePath(textFile);
-    // 保存 saveFilePath 到文件
-    // saveSaveFilePath(textFile);
-
-    // 执行保存操作
-    QFile file(filePath);
-    if (!file.open(QIODevice::WriteOnly)) {
-        QMessageBox::critical(this, tr("保存失败"), tr("无法打开或写入工程信息."));
-        return "default";
-    }
-    fileCount++;  // 增加文件计数
-    autoCleanStack();  // 调用清理函数
-    // 创建 QTextStream 对象，并指定编码为 UTF-8
-    QTextStream out(&file);
-    // 获取 DiagramItem 结构体指针列表
-    QList<WriteDiagramItem*> diagramItems = getStructList();
-    // 写入 DiagramItem 结构体列表的大小
-    out << "DT_Size_" << diagramItems.size() << "\n";
-    // 遍历 DiagramItem 结构体指针列表
-    for (WriteDiagramItem* itemPtr : diagramItems) {
-        // 替换 internalText 和 texttype 中的空格为星号
-        QString modifiedInternalText = itemPtr->internalText.replace(" ", "*");
-        QString modifiedTextType = itemPtr->texttype.replace(" ", "*");
-
-        // 写入结构体成员
-        out << itemPtr->x << " "
-            << itemPtr->y << " "
-            << itemPtr->width << " "
-            << itemPtr->height << " "
-            << itemPtr->type << " ";
-        for (int i = 0; i < 4; ++i) {
-            out << itemPtr->rbg[i] << " ";
-        }
-        out << modifiedInternalText << " " // 使用替换后的 internalText
-            << itemPtr->itemtype << " "
-            << modifiedTextType << " " // 使用替换后的 texttype
-            << itemPtr->textsize << " "
-            << itemPtr->boldtype << " "
-            << itemPtr->itlatic << " ";
-        for (int i = 0; i < 4; ++i) {
-            out << itemPtr->textrbg[i] << " ";
-        }
-        out << "\n";
-    }
-    // 关闭文件
-    file.close();
-
-    // 获取 DiagramPath 结构体指针列表
-    // 获取 DiagramPath 结构体指针列表
-    QList<struct WriteDiagramPath *> diagramPathsPtrs = getStructList1();
-    // 如果用户取消了文件选择或列表为空，则不执行任何操作
-    if(!diagramPathsPtrs.isEmpty()){
-        if (textFile.isEmpty() || diagramPathsPtrs.isEmpty()) {
-            qDebug()<<"empty";
-            saveFileSuccess = false;
-            return "default";
-        }
-        // 以追加模式打开文件，以写入 DiagramPath 数据
-        if (!file.open(QIODevice::Append)) {
-            QMessageBox::critical(this, tr("保存失败"), tr("无法打开或写入工程信息."));
-            saveFileSuccess = false;
-            return "default";
-        }
-        // 写入 DiagramPath 结构体列表的大小
-        out << "LN_Size_" << diagramPathsPtrs.size() << "\n";
-
-        // 遍历 DiagramPath 结构体指针列表
-        for (struct WriteDiagramPath *pathPtr : diagramPathsPtrs) {
-            if (pathPtr) {
-                // 写入结构体成员
-                out << pathPtr->start << " "
-                    << pathPtr->startp << " "
-                    << pathPtr->end << " "
-                    << pathPtr->endp << "\n";
-            }
-        }
-    }
-    // 关闭文件
-    file.close();
-    undoStack.push(textFile);
-    path++;
-    return textFile;
+//以下槽把场景发出的编辑信号转成增量命令压栈
+void MainWindow::recordItemInserted(DiagramItem *item) {
+    undoStack->push(new AddItemCommand(scene, item));
 }
 
-void MainWindow::loadfilestack(QString str) {
-    // QString currentDir = QDir::currentPath();
-    qDebug()<<"执行loadfilesstack";
-    QDir dir("stacks");
-
-    QString filePath = dir.filePath(str);
-
-    // 执行保存操作
-    QFile file(filePath);
-
-    // 以只读模式打开文件
-    if (file.open(QIODevice::ReadOnly)) {
-        // 创建 QTextStream 对象
-        QTextStream in(&file);
+void MainWindow::recordTextInserted(QGraphicsTextItem *item) {
+    undoStack->push(new AddItemCommand(scene, item));
+}
 
-        // 创建新的列表用于存放读取的数据
-        QList<ReadDiagramItem> readDiagramItems;
-
-        // 读取 DiagramItem 结构体列表的大小
-        QString sizeString;
-        in >> sizeString;
-        if (sizeString.startsWith("DT_Size_")) {
-            quint32 diagramItemCount = sizeString.mid(8).toUInt(); // 去掉前缀并转换为整数
-            for (quint32 i = 0; i < diagramItemCount; ++i) {
-                ReadDiagramItem item;
-                in >> item.x >> item.y >> item.width >> item.height >> item.type;
-                for (int j = 0; j < 4; ++j) {
-                    in >> item.rbg[j];
-                }
-                // 读取 internalText 并替换星号为空格
-                QString internalText;
-                in >> internalText;
-                item.internalText = internalText.replace("*", " ");
-                in >> item.itemtype;
-                // 读取 texttype 并替换星号为空格
-                QString textType;
-                in >> textType;
-                item.texttype = textType.replace("*", " ");
-                in >> item.textsize;
-                // 读取布尔值需要特殊处理
-                QString boldTypeStr;
-                in >> boldTypeStr;
-                item.boldtype = (boldTypeStr == "true");
-
-                QString itlaticStr;
-                in >> itlaticStr;
-                item.itlatic = (itlaticStr == "true");
-
-                for (int j = 0; j < 4; ++j) {
-                    in >> item.textrbg[j];
-                }
+void MainWindow::recordPathInserted(DiagramPath *path) {
+    undoStack->push(new AddPathCommand(scene, path));
+}
 
-                readDiagramItems.append(item);
-            }
+//空文本项失焦清理 场景只发通知 移除和释放都由命令负责
+void MainWindow::recordTextRemoved(DiagramTextItem *item) {
+    //索引按指针建键 项离场就摘掉 免得地址复用后查到别人的旧文本
+    //撤销重新入场时matches()的懒索引会把它补回来
+    textIndex.removeItem(item);
+    undoStack->push(new RemoveTextCommand(scene, item));
+}
 
-        }
+void MainWindow::recordItemMoved(QGraphicsItem *item, const QPointF &oldPos) {
+    undoStack->push(new MoveItemCommand(item, oldPos, item->pos()));
+}
 
-        QList<ReadDiagramPath> readDiagramPaths;
-        in >> sizeString;
-        if (sizeString.startsWith("LN_Size_")) {
-            quint32 diagramPathCount = sizeString.mid(8).toUInt(); // 去掉前缀并转换为整数
-            for (quint32 i = 0; i < diagramPathCount; ++i) {
-                ReadDiagramPath path;
-                in >> path.start >> path.startp >> path.end >> path.endp;
-                // 调试输出每个读取到的 DiagramPath
-                qDebug() << "Read DiagramPath:";
-                qDebug() << "start: " << path.start;
-                qDebug() << "startp: " << path.startp;
-                qDebug() << "end: " << path.end;
-                qDebug() << "endp: " << path.endp;
-                readDiagramPaths.append(path);
-            }
-        }
-        scene->clear();
-
-        QList<DiagramItem *> DiagramItemList;
-
-        foreach (ReadDiagramItem item,readDiagramItems) {
-            DiagramItem *item1=new DiagramItem(static_cast<DiagramItem::DiagramType>(item.itemtype),itemMenu);
-            item1->setPos(QPoint(item.x,item.y));
-            item1->setFixedSize(QSize(item.width,item.height));
-            QColor itemcolor(item.rbg[0],item.rbg[2],item.rbg[1],item.rbg[3]);
-            QColor textcolor(item.textrbg[0],item.textrbg[2],item.textrbg[1],item.textrbg[3]);
-            item1->m_color=itemcolor;
-            item1->textItem->setPlainText(item.internalText);
-            item1->textItem->font().setPointSize(item.textsize);
-            item1->textItem->font().setFamily(item.texttype);
-            item1->textItem->font().setBold(item.boldtype);
-            item1->textItem->font().setItalic(item.itlatic);
-            item1->textItem->setDefaultTextColor(textcolor);
-            scene->addItem(item1);
-            DiagramItemList.append(item1);
-        }
-        int size = DiagramItemList.size();
-        qDebug()<<"size: "<< size;
-        foreach (ReadDiagramPath item,readDiagramPaths) {
-            DiagramItem *startItem = DiagramItemList.at(item.start-1 );
-            DiagramItem *endItem = DiagramItemList.at(item.end-1 );
-            qDebug()<<scene->items();
-            DiagramItem::TransformState startState = static_cast<DiagramItem::TransformState>(item.startp);
-            DiagramItem::TransformState endState = static_cast<DiagramItem::TransformState>(item.endp);
-
-            DiagramPath *item1=new DiagramPath(startItem,endItem,startState,endState);
-
-            startItem->addPathes(item1);
-            startItem->marks[item1] = "1" + QString::number(startState);
-            qDebug()<<startItem->marks;
-            endItem->addPathes(item1);
-            endItem->marks[item1] = "0" + QString::number(endState);
-            qDebug()<<endItem->marks;
-            qDebug()<<startState<<endState;
-            item1->updatePath();
-            item1->setZValue(-1000.0);
-
-            scene->addItem(item1);
-
-        }        // 提示用户读取成功
-        // QMessageBox::information(this, tr("加载完成"), tr("成功加载工程."));
-    } else {
-        // 文件打开失败，提示用户错误信息
-        QMessageBox::critical(this, tr("加载失败"), tr("无法打开或读取文件信息."));
-    }
+void MainWindow::recordItemsMoved(const QList<QGraphicsItem *> &items,
+                                  const QList<QPointF> &oldPositions) {
+    //整批拖动只压一条复合命令 撤销一次回退全部位移
+    QUndoCommand *moveCommand = new QUndoCommand(tr("移动"));
+    for (int i = 0; i < items.size(); ++i)
+        new MoveItemCommand(items.at(i), oldPositions.at(i),
+                            items.at(i)->pos(), moveCommand);
+    undoStack->push(moveCommand);
 }
@@ -9,11 +9,23 @@
 #include <QMainWindow>
 #include <QPixmap>
 #include "diagramitem.h"
-#include <QStack>
 #include "findreplacedialog.h"  // 包含新添加的查找和替换对话框
 #include "diagramtextitem.h"// 确保包含了 DiagramTextItem 的头文件
+#include "projectrecords.h"
+#include "objectpool.h"
+#include "textsearchindex.h"
+#include "historyring.h"
 
 class DiagramScene;
+class AutosaveManager;
+class ImageExporter;
+class MinimapWidget;
+
+QT_BEGIN_NAMESPACE
+class QUndoStack;
+class QTimer;
+class QProgressDialog;
+QT_END_NAMESPACE
 
 QT_BEGIN_NAMESPACE
 class QAction;
@@ -38,6 +50,7 @@ class MainWindow : public QMainWindow
 
 public:
     MainWindow();
+    ~MainWindow();
 
 
 public slots:
@@ -85,20 +98,40 @@ private slots:
     void loadfile();
     QList<struct WriteDiagramItem *> getStructList();
     QList<struct WriteDiagramPath *> getStructList1();
-    QString savefilestack();
-    void loadfilestack(QString str);
-    void autoCleanStack();
+    void recordItemInserted(DiagramItem *item);     //编辑操作入撤销栈
+    void recordTextInserted(QGraphicsTextItem *item);
+    void recordPathInserted(DiagramPath *path);
+    void recordTextRemoved(DiagramTextItem *item);  //空文本项失焦 删除也走命令通道
+    void recordItemMoved(QGraphicsItem *item, const QPointF &oldPos);
+    void recordItemsMoved(const QList<QGraphicsItem *> &items,
+                          const QList<QPointF> &oldPositions);   //整批位移合成一条撤销记录
     void undo();
     void redo();
-
-
-    // void undo();
-    // void redo();
+    void rollbackSnapshot();    //回滚到内存历史环里最近一份快照
+    void toggleObstacleAvoidance(bool enabled); //避障开关 现有连线立刻按新策略重解
+    void hibernateIdleTabs();   //定时巡检 把后台闲置标签页的场景压缩休眠
+    void scheduleAutosave();    //编辑后重置延迟计时 把连续编辑合并成一次快照
+    void performAutosave();     //计时到点 GUI线程做值快照交给工作线程写盘
+    void updateTextIndex(DiagramTextItem *item);    //标签编辑结束 增量更新全文索引
+    void exportProgressChanged(int done, int total);    //导出进度条跟进条带渲染
+    void exportDone(bool ok, const QString &fileName);  //导出收尾 弹成功/失败提示
+    void exportAborted();                               //用户取消导出 收掉进度条
 
 
 private:
     void saveSavePicPath(const QString &filePath);
     QString loadSavePicPath();
+    QUndoStack *undoStackFor(DiagramScene *targetScene);    //取标签页自己的撤销栈 没有就建
+    void snapshotScene(DiagramScene *targetScene,
+                       QList<struct WriteDiagramItem> &items,
+                       QList<struct WriteDiagramPath> &paths);  //自动保存/休眠用的值快照
+    void wakeScene(DiagramScene *targetScene);  //激活休眠标签页时按快照重建
+    void purgeTextIndex(DiagramScene *targetScene); //整场景拆除前把文本项从全文索引摘掉
+    void updateTabMemoryInfo(); //标签页提示里写清活跃对象数或休眠快照大小
+    void startImageExport(const QString &fileName); //把整幅场景交给离屏导出流水线
+    void populateScene(const QList<struct ReadDiagramItem> &readDiagramItems,
+                       const QList<struct ReadDiagramPath> &readDiagramPaths); //按记录批量重建场景
+    void promoteMatchingLabels(const QString &needle);  //查找前把命中的标签提升成文本项
 
     void createToolBox();
     void createActions();
@@ -138,6 +171,8 @@ private:
     QAction *aboutAction;
     QAction *undoAction;
     QAction *redoAction;
+    QAction *rollbackAction;
+    QAction *avoidanceAction;
 
 
     QMenu *fileMenu;
@@ -176,14 +211,24 @@ private:
     QVector<DiagramScene*> sceneVector;
     QVector<QGraphicsView*> viewVector;
 
-    QStack<QString> undoStack;
-    QStack<QString> redoStack;
+    QUndoStack *undoStack;  // 当前标签页的撤销栈 切标签页时跟着换
+    QHash<DiagramScene*, QUndoStack*> undoStacks;  // 每个标签页一个栈 命令只引用自己场景的图元
+    AutosaveManager *autosaveManager;   // 自动保存写盘流水线 跑在工作线程
+    QTimer *autosaveTimer;              // 编辑防抖计时器
+    RecordPool<WriteDiagramItem> writeItemPool;  // 快照记录池 每轮reset复用
+    RecordPool<WriteDiagramPath> writePathPool;
+    TextSearchIndex textIndex;  // 查找替换的全文索引 标签改动时增量维护
+    ImageExporter *imageExporter;   // 离屏图片导出流水线 条带渲染+工作线程编码
+    HistoryRing historyRing;    // 压缩内存历史环 每次自动保存同时入环
+    QHash<DiagramScene*, QByteArray> hibernatedScenes;  // 休眠标签页的压缩快照
+    QHash<DiagramScene*, qint64> sceneLastActive;       // 各标签页最后一次处于前台的时间
+    QTimer *hibernateTimer;     // 后台标签页休眠巡检
+    QProgressDialog *exportProgress = nullptr;  // 导出进度对话框 每次导出现建
+    MinimapWidget *minimap; // 导航小地图 始终指向当前标签页的场景/视图
 
     FindReplaceDialog *findReplaceDialog;  // 查找和替换对话框指针
     DiagramTextItem *currentTextItem = nullptr;  // 当前查找的文本项
     int lastSearchPosition = -1;
-    int path=0;
-    int fileCount=0;
 };
 //! [0]
 
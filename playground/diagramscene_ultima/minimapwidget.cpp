@@ -0,0 +1,152 @@
+#include "minimapwidget.h"
+#include <QGraphicsScene>
+#include <QGraphicsView>
+#include <QPainter>
+#include <QMouseEvent>
+#include <QScrollBar>
+#include <QTimer>
+
+MinimapWidget::MinimapWidget(QWidget *parent)
+    : QWidget(parent)
+{
+    setMinimumSize(160, 120);
+    flushTimer = new QTimer(this);
+    flushTimer->setSingleShot(true);
+    flushTimer->setInterval(100);
+    connect(flushTimer, &QTimer::timeout, this, &MinimapWidget::flushDamage);
+}
+
+void MinimapWidget::setTarget(QGraphicsScene *newScene, QGraphicsView *newView)
+{
+    if (scene != nullptr)
+        disconnect(scene, nullptr, this, nullptr);
+    if (view != nullptr) {
+        disconnect(view->horizontalScrollBar(), nullptr, this, nullptr);
+        disconnect(view->verticalScrollBar(), nullptr, this, nullptr);
+    }
+
+    scene = newScene;
+    view = newView;
+    pendingDamage.clear();
+
+    if (scene != nullptr)
+        connect(scene, &QGraphicsScene::changed, this, &MinimapWidget::sceneDamaged);
+    if (view != nullptr) {
+        //主视图滚动/缩放时只要重画视口框 缓存不动
+        connect(view->horizontalScrollBar(), &QScrollBar::valueChanged,
+                this, qOverload<>(&QWidget::update));
+        connect(view->verticalScrollBar(), &QScrollBar::valueChanged,
+                this, qOverload<>(&QWidget::update));
+    }
+    rebuildCache();
+}
+
+QRectF MinimapWidget::cacheRectFor(const QRectF &sceneRect) const
+{
+    if (scene == nullptr)
+        return QRectF();
+    const QRectF bounds = scene->sceneRect();
+    return QRectF((sceneRect.x() - bounds.x()) * mapScale + mapOffset.x(),
+                  (sceneRect.y() - bounds.y()) * mapScale + mapOffset.y(),
+                  sceneRect.width() * mapScale,
+                  sceneRect.height() * mapScale);
+}
+
+void MinimapWidget::rebuildCache()
+{
+    cache = QImage(size(), QImage::Format_ARGB32_Premultiplied);
+    cache.fill(Qt::white);
+    if (scene == nullptr) {
+        update();
+        return;
+    }
+    const QRectF bounds = scene->sceneRect();
+    mapScale = qMin(width() / bounds.width(), height() / bounds.height());
+    mapOffset = QPointF((width() - bounds.width() * mapScale) / 2,
+                        (height() - bounds.height() * mapScale) / 2);
+    QPainter painter(&cache);
+    painter.setRenderHint(QPainter::SmoothPixmapTransform);
+    scene->render(&painter, cacheRectFor(bounds), bounds);
+    update();
+}
+
+void MinimapWidget::renderRegion(const QRectF &sceneRegion)
+{
+    const QRectF target = cacheRectFor(sceneRegion);
+    QPainter painter(&cache);
+    painter.setRenderHint(QPainter::SmoothPixmapTransform);
+    painter.setClipRect(target);
+    painter.fillRect(target, Qt::white);
+    scene->render(&painter, target, sceneRegion);
+}
+
+void MinimapWidget::sceneDamaged(const QList<QRectF> &regions)
+{
+    pendingDamage.append(regions);
+    if (!flushTimer->isActive())
+        flushTimer->start();
+}
+
+void MinimapWidget::flushDamage()
+{
+    if (scene == nullptr || pendingDamage.isEmpty())
+        return;
+    //脏区面积超过半个场景就整图重建 省得逐块画反而更慢
+    qreal damagedArea = 0;
+    for (const QRectF &region : std::as_const(pendingDamage))
+        damagedArea += region.width() * region.height();
+    const QRectF bounds = scene->sceneRect();
+    if (damagedArea > bounds.width() * bounds.height() / 2) {
+        pendingDamage.clear();
+        rebuildCache();
+        return;
+    }
+    for (const QRectF &region : std::as_const(pendingDamage))
+        renderRegion(region.intersected(bounds));
+    pendingDamage.clear();
+    update();
+}
+
+QRectF MinimapWidget::viewportSceneRect() const
+{
+    if (view == nullptr)
+        return QRectF();
+    return view->mapToScene(view->viewport()->rect()).boundingRect();
+}
+
+void MinimapWidget::paintEvent(QPaintEvent *)
+{
+    QPainter painter(this);
+    painter.drawImage(0, 0, cache);
+    if (view == nullptr)
+        return;
+    //当前视口框 拖它平移主视图
+    const QRectF frame = cacheRectFor(viewportSceneRect());
+    painter.setPen(QPen(Qt::red, 1));
+    painter.setBrush(QColor(255, 0, 0, 24));
+    painter.drawRect(frame.intersected(rect()));
+}
+
+void MinimapWidget::resizeEvent(QResizeEvent *)
+{
+    rebuildCache();
+}
+
+void MinimapWidget::mousePressEvent(QMouseEvent *event)
+{
+    mouseMoveEvent(event);
+}
+
+void MinimapWidget::mouseMoveEvent(QMouseEvent *event)
+{
+    if (scene == nullptr || view == nullptr || mapScale <= 0)
+        return;
+    if (!(event->buttons() & Qt::LeftButton))
+        return;
+    //点击/拖动位置换算回场景坐标 主视图对中过去
+    const QRectF bounds = scene->sceneRect();
+    const QPointF scenePos(bounds.x() + (event->position().x() - mapOffset.x()) / mapScale,
+                           bounds.y() + (event->position().y() - mapOffset.y()) / mapScale);
+    view->centerOn(scenePos);
+    update();
+}
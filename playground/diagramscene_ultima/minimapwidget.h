@@ -0,0 +1,50 @@
+#ifndef MINIMAPWIDGET_H
+#define MINIMAPWIDGET_H
+
+#include <QWidget>
+#include <QImage>
+#include <QList>
+#include <QRectF>
+
+class QGraphicsScene;
+class QGraphicsView;
+class QTimer;
+
+//导航小地图
+//整幅场景降采样后缓存成一张小图 场景changed信号报的脏区按块增量重画
+//叠加当前视口框 拖拽框即平移主视图 导航全程不触发全分辨率重绘
+class MinimapWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit MinimapWidget(QWidget *parent = nullptr);
+
+    void setTarget(QGraphicsScene *newScene, QGraphicsView *newView);   //切标签页时指向当前场景/视图
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+
+private slots:
+    void sceneDamaged(const QList<QRectF> &regions);    //changed脏区先攒着 合帧后统一补画
+    void flushDamage();
+
+private:
+    void rebuildCache();    //整图重建 换场景/改大小/脏区过半时用
+    void renderRegion(const QRectF &sceneRegion);   //只把一块脏区重画进缓存
+    QRectF cacheRectFor(const QRectF &sceneRect) const; //场景矩形换算到缓存像素
+    QRectF viewportSceneRect() const;   //主视图当前可见的场景范围
+
+    QGraphicsScene *scene = nullptr;
+    QGraphicsView *view = nullptr;
+    QImage cache;           //降采样场景缓存
+    qreal mapScale = 1.0;   //场景到缓存的缩放系数
+    QPointF mapOffset;      //缓存里的内容偏移 场景居中摆放
+    QList<QRectF> pendingDamage;
+    QTimer *flushTimer;     //脏区合帧 100ms批量补画一次
+};
+
+#endif // MINIMAPWIDGET_H
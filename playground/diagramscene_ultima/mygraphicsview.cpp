@@ -1,5 +1,11 @@
 #include "mygraphicsview.h"
 #include "mainwindow.h"
+#include "perftrace.h"
+#include "diagramitem.h"
+#include <QElapsedTimer>
+#include <QPainter>
+#include <QOpenGLWidget>
+#include <QSurfaceFormat>
 
 MyGraphicsView::MyGraphicsView(QWidget *parent) : QGraphicsView(parent)
 {
@@ -15,6 +21,112 @@ void MyGraphicsView::contextMenuEvent(QContextMenuEvent *event)
     if (selectedAction == pAction) {
         // Convert event position to scene coordinates
         QPointF scenePos = mapToScene(event->pos());
-        static_cast<MainWindow*>(parent())->pasteItems(scenePos);
+        //视图可能挂在标签页里 父链上不一定直接是主窗口 用window()拿顶层
+        MainWindow *mainWindow = qobject_cast<MainWindow *>(window());
+        if (mainWindow != nullptr)
+            mainWindow->pasteItems(scenePos);
     }
 }
+
+void MyGraphicsView::setGpuViewport(bool enable)
+{
+    if (enable == gpuViewport)
+        return;
+    gpuViewport = enable;
+    if (enable) {
+        //抗锯齿交给MSAA在GPU上做 CPU侧不再逐像素算
+        QOpenGLWidget *glViewport = new QOpenGLWidget;
+        QSurfaceFormat format = QSurfaceFormat::defaultFormat();
+        format.setSamples(4);
+        glViewport->setFormat(format);
+        setViewport(glViewport);
+        //GL合成没有局部滚动加速 小脏区反而亏 整帧重画
+        setViewportUpdateMode(QGraphicsView::FullViewportUpdate);
+    } else {
+        //远程桌面等部署回退软件光栅 也是默认状态
+        setViewport(new QWidget);
+        setViewportUpdateMode(QGraphicsView::MinimalViewportUpdate);
+    }
+    cachePolicy = -1;
+    applyItemCachePolicy();
+}
+
+//接近1:1时用设备坐标缓存 保持清晰 深度缩放时用图元坐标缓存 换挡不重栅格化
+//只在缩放跨档时重刷一遍场景 开关切换后新插入的图元等下一次跨档补上
+void MyGraphicsView::applyItemCachePolicy()
+{
+    if (scene() == nullptr)
+        return;
+    int wanted = 0;
+    if (gpuViewport) {
+        const qreal zoom = transform().m11();
+        wanted = (zoom >= 0.75 && zoom <= 1.5) ? 1 : 2;
+    }
+    if (wanted == cachePolicy)
+        return;
+    cachePolicy = wanted;
+    const QGraphicsItem::CacheMode mode =
+        wanted == 1 ? QGraphicsItem::DeviceCoordinateCache
+        : wanted == 2 ? QGraphicsItem::ItemCoordinateCache
+                      : QGraphicsItem::NoCache;
+    const QList<QGraphicsItem *> itemList = scene()->items();
+    for (QGraphicsItem *item : itemList) {
+        if (item->type() == DiagramItem::Type)
+            item->setCacheMode(mode);
+    }
+}
+
+void MyGraphicsView::keyPressEvent(QKeyEvent *event)
+{
+    if (event->key() == Qt::Key_F11) {
+        //F11做GPU/raster的运行时A/B切换
+        setGpuViewport(!gpuViewport);
+        return;
+    }
+    if (event->key() == Qt::Key_F12) {
+        if (event->modifiers() & Qt::ShiftModifier) {
+            //Shift+F12 把内存里的事件环落盘 附到性能工单上
+            PerfTrace::instance().dumpTrace(QStringLiteral("perftrace.json"));
+        } else {
+            hudVisible = !hudVisible;
+            PerfTrace::enabled = hudVisible;    //HUD关着时所有打点归零开销
+            viewport()->update();
+        }
+        return;
+    }
+    QGraphicsView::keyPressEvent(event);
+}
+
+void MyGraphicsView::paintEvent(QPaintEvent *event)
+{
+    if (gpuViewport)
+        applyItemCachePolicy(); //缩放跨档时换缓存策略 同档直接返回
+
+    if (!hudVisible) {
+        QGraphicsView::paintEvent(event);
+        return;
+    }
+
+    QElapsedTimer frameTimer;
+    frameTimer.start();
+    QGraphicsView::paintEvent(event);
+    lastFrameMs = frameTimer.nsecsElapsed() / 1e6;
+    PerfTrace::instance().recordEvent("view.frame", PerfTrace::instance().nowUs(),
+                                      qint64(lastFrameMs * 1000));
+
+    //帧内各处打的计数 读一次就清零 所以显示的是本帧增量
+    const qint64 painted = PerfTrace::instance().takeCount("paint.items");
+    const qint64 rerouted = PerfTrace::instance().takeCount("reroute.paths");
+
+    QPainter painter(viewport());
+    painter.setRenderHint(QPainter::TextAntialiasing);
+    const QString hudText = QString("%1 ms  |  items painted: %2  |  paths rerouted: %3  |  events: %4")
+            .arg(lastFrameMs, 0, 'f', 2)
+            .arg(painted)
+            .arg(rerouted)
+            .arg(PerfTrace::instance().eventCount());
+    const QRect hudRect(8, 8, painter.fontMetrics().horizontalAdvance(hudText) + 16, 22);
+    painter.fillRect(hudRect, QColor(0, 0, 0, 160));
+    painter.setPen(Qt::green);
+    painter.drawText(hudRect.adjusted(8, 0, -8, 0), Qt::AlignVCenter, hudText);
+}
@@ -5,6 +5,8 @@
 #include <QAction>
 #include <QMenu>
 #include <QContextMenuEvent>
+#include <QKeyEvent>
+#include <QPaintEvent>
 
 class MyGraphicsView : public QGraphicsView
 {
@@ -13,11 +15,22 @@ class MyGraphicsView : public QGraphicsView
 public:
     MyGraphicsView(QWidget *parent = nullptr);
 
+    void setGpuViewport(bool enable);   //OpenGL视口开关 F11运行时切换 方便A/B对比
+    bool gpuViewportEnabled() const { return gpuViewport; }
+
 protected:
     void contextMenuEvent(QContextMenuEvent *event) override;
+    void keyPressEvent(QKeyEvent *event) override;      //F12开关HUD Shift+F12导出trace F11开关GPU视口
+    void paintEvent(QPaintEvent *event) override;       //HUD打开时叠加帧耗时和计数
 
 private:
+    void applyItemCachePolicy();    //按当前缩放档给DiagramItem选图元缓存策略
+
     QAction *pAction;  // Declare the QAction pointer
+    bool hudVisible = false;    //性能HUD开关
+    qreal lastFrameMs = 0;      //上一帧paintEvent耗时
+    bool gpuViewport = false;   //GPU视口开关 默认raster 远程桌面部署不动它
+    int cachePolicy = -1;       //上次应用的缓存策略 -1未应用 0关 1设备坐标 2图元坐标
 };
 
 #endif // MYGRAPHICSVIEW_H
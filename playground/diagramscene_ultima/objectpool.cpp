@@ -0,0 +1,43 @@
+#include "objectpool.h"
+
+FixedBlockPool::FixedBlockPool(std::size_t blockSize, int blocksPerChunk)
+    : m_blocksPerChunk(blocksPerChunk)
+{
+    //块至少要放得下一个链表指针 并对齐到16字节
+    if (blockSize < sizeof(void *))
+        blockSize = sizeof(void *);
+    m_blockSize = (blockSize + 15) & ~std::size_t(15);
+}
+
+FixedBlockPool::~FixedBlockPool()
+{
+    for (char *chunk : m_chunks)
+        delete[] chunk;
+}
+
+void FixedBlockPool::grow()
+{
+    char *chunk = new char[m_blockSize * m_blocksPerChunk];
+    m_chunks.append(chunk);
+    //切成块 串进自由链表
+    for (int i = 0; i < m_blocksPerChunk; ++i) {
+        void *block = chunk + i * m_blockSize;
+        *reinterpret_cast<void **>(block) = m_freeList;
+        m_freeList = block;
+    }
+}
+
+void *FixedBlockPool::allocate()
+{
+    if (m_freeList == nullptr)
+        grow();
+    void *block = m_freeList;
+    m_freeList = *reinterpret_cast<void **>(block);
+    return block;
+}
+
+void FixedBlockPool::deallocate(void *block)
+{
+    *reinterpret_cast<void **>(block) = m_freeList;
+    m_freeList = block;
+}
@@ -0,0 +1,64 @@
+#ifndef OBJECTPOOL_H
+#define OBJECTPOOL_H
+
+#include <QVector>
+#include <cstddef>
+
+//定长块的自由链表池 给DiagramItem/DiagramPath的operator new/delete用
+//删除的块回到链表里 下次粘贴/撤销/加载直接复用 长会话不再碎片化
+//池本身不加锁 使用方按线程各建一个 块不跨线程分配释放
+class FixedBlockPool
+{
+public:
+    explicit FixedBlockPool(std::size_t blockSize, int blocksPerChunk = 256);
+    ~FixedBlockPool();
+
+    void *allocate();
+    void deallocate(void *block);
+
+private:
+    void grow();    //自由链表空了 再要一整块chunk切开挂上
+
+    std::size_t m_blockSize;
+    int m_blocksPerChunk;
+    void *m_freeList = nullptr;     //每个空闲块的开头存下一块的指针
+    QVector<char *> m_chunks;       //整块内存 析构时统一归还
+};
+
+//快照记录池 每轮快照reset后复用上一轮的对象
+//以前getStructList每个图元new一条记录且无人释放 长会话RSS一直涨
+template <typename T>
+class RecordPool
+{
+public:
+    ~RecordPool()
+    {
+        qDeleteAll(m_records);
+    }
+
+    //新一轮快照开始 已有对象全部标记为可复用
+    void reset()
+    {
+        m_used = 0;
+    }
+
+    //取一条干净记录 池子不够时才真正分配
+    T *take()
+    {
+        if (m_used < m_records.size()) {
+            T *record = m_records.at(m_used++);
+            *record = T();
+            return record;
+        }
+        T *record = new T();
+        m_records.append(record);
+        ++m_used;
+        return record;
+    }
+
+private:
+    QList<T *> m_records;
+    int m_used = 0;
+};
+
+#endif // OBJECTPOOL_H
@@ -0,0 +1,74 @@
+#include "perftrace.h"
+#include <QFile>
+#include <QDebug>
+
+bool PerfTrace::enabled = false;
+bool PerfTrace::verboseLog = false;
+
+PerfTrace &PerfTrace::instance()
+{
+    static PerfTrace trace;
+    return trace;
+}
+
+PerfTrace::PerfTrace()
+{
+    clock.start();
+    events.reserve(1024);
+}
+
+void PerfTrace::recordEvent(const char *name, qint64 startUs, qint64 durUs)
+{
+    TraceEvent event{name, startUs, durUs};
+    if (events.size() < MaxEvents) {
+        events.append(event);
+    } else {
+        //环满了覆盖最老的一条
+        events[writeIndex] = event;
+        writeIndex = (writeIndex + 1) % MaxEvents;
+    }
+    ++storedEvents;
+}
+
+void PerfTrace::addCount(const char *name, qint64 n)
+{
+    counts[QByteArray(name)] += n;
+}
+
+qint64 PerfTrace::takeCount(const char *name)
+{
+    return counts.take(QByteArray(name));
+}
+
+bool PerfTrace::dumpTrace(const QString &fileName) const
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qDebug() << "无法写入性能trace文件:" << fileName;
+        return false;
+    }
+    //chrome://tracing的事件数组格式 ph=X是完整事件(起点+时长)
+    file.write("{\"traceEvents\":[\n");
+    for (int i = 0; i < events.size(); ++i) {
+        const TraceEvent &event = events.at(i);
+        QByteArray line = "{\"name\":\"" + QByteArray(event.name)
+                + "\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":"
+                + QByteArray::number(event.startUs)
+                + ",\"dur\":" + QByteArray::number(event.durUs) + "}";
+        if (i + 1 < events.size())
+            line += ",";
+        line += "\n";
+        file.write(line);
+    }
+    file.write("]}\n");
+    qDebug() << "性能trace已导出:" << fileName << events.size() << "条事件";
+    return true;
+}
+
+void PerfTrace::clear()
+{
+    events.clear();
+    writeIndex = 0;
+    storedEvents = 0;
+    counts.clear();
+}
@@ -0,0 +1,67 @@
+#ifndef PERFTRACE_H
+#define PERFTRACE_H
+
+#include <QElapsedTimer>
+#include <QVector>
+#include <QHash>
+#include <QByteArray>
+#include <QString>
+
+//性能采样器
+//enabled关着时所有打点只剩一次bool判断 对正常运行零开销
+//事件攒在内存环里 可随时导出chrome://tracing格式的JSON附到性能工单
+class PerfTrace
+{
+public:
+    struct TraceEvent {
+        const char *name;   //打点名 要求是静态字符串
+        qint64 startUs;
+        qint64 durUs;
+    };
+
+    static bool enabled;    //采样总开关 HUD打开时置true
+    static bool verboseLog; //啰嗦日志开关 保存/加载里的逐条qDebug归它管
+
+    static PerfTrace &instance();
+
+    qint64 nowUs() const { return clock.nsecsElapsed() / 1000; }
+    void recordEvent(const char *name, qint64 startUs, qint64 durUs);
+    void addCount(const char *name, qint64 n);  //累计计数 HUD每帧读取
+
+    qint64 takeCount(const char *name); //读出计数并清零
+    qint64 eventCount() const { return storedEvents; }
+
+    bool dumpTrace(const QString &fileName) const;  //导出chrome://tracing JSON
+    void clear();
+
+private:
+    PerfTrace();
+
+    static const int MaxEvents = 200000;    //事件环上限 超出丢最老的
+
+    QElapsedTimer clock;
+    QVector<TraceEvent> events;
+    int writeIndex = 0;
+    qint64 storedEvents = 0;
+    QHash<QByteArray, qint64> counts;
+};
+
+//作用域计时 构造到析构算一个事件 开关关着时什么都不做
+class PerfScope
+{
+public:
+    explicit PerfScope(const char *name)
+        : name(name), startUs(PerfTrace::enabled ? PerfTrace::instance().nowUs() : -1) {}
+    ~PerfScope()
+    {
+        if (startUs >= 0)
+            PerfTrace::instance().recordEvent(name, startUs,
+                                              PerfTrace::instance().nowUs() - startUs);
+    }
+
+private:
+    const char *name;
+    qint64 startUs;
+};
+
+#endif // PERFTRACE_H
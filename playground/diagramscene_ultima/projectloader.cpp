@@ -0,0 +1,195 @@
+#include "projectloader.h"
+
+#include "binaryprojectfile.h"
+#include "diagramscene.h"
+#include "diagramitem.h"
+#include "diagrampath.h"
+#include "perftrace.h"
+
+#include <QFile>
+#include <QTextStream>
+#include <QThread>
+#include <QtConcurrent>
+#include <QDebug>
+
+bool ProjectLoader::loadProject(const QString &fileName,
+                                QList<ReadDiagramItem> &readDiagramItems,
+                                QList<ReadDiagramPath> &readDiagramPaths)
+{
+    if (BinaryProjectFile::isBinary(fileName)) {
+        // 新二进制格式 映射到内存后按定长记录直接读取
+        return BinaryProjectFile::load(fileName, readDiagramItems, readDiagramPaths);
+    }
+    // 旧文本格式的回退读取
+    return parseLegacyProject(fileName, readDiagramItems, readDiagramPaths);
+}
+
+//旧文本格式的并行解析
+//每条item记录token数固定 先整体切token 再按核数分块交给QtConcurrent
+//mapped保持块顺序 拼回来就是原记录顺序 连线记录只有4个int 串行读完
+bool ProjectLoader::parseLegacyProject(const QString &fileName,
+                                       QList<ReadDiagramItem> &readDiagramItems,
+                                       QList<ReadDiagramPath> &readDiagramPaths)
+{
+    PerfScope scope("loader.parseLegacyProject");
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+    QTextStream in(&file);
+    const QString content = in.readAll();
+
+    //手工扫一遍切token QTextStream逐词读在大文件上太慢
+    QList<QStringView> tokens;
+    const QStringView view(content);
+    qsizetype tokenBegin = -1;
+    for (qsizetype i = 0; i <= view.size(); ++i) {
+        const bool isSpace = i == view.size() || view.at(i).isSpace();
+        if (!isSpace && tokenBegin < 0)
+            tokenBegin = i;
+        else if (isSpace && tokenBegin >= 0) {
+            tokens.append(view.mid(tokenBegin, i - tokenBegin));
+            tokenBegin = -1;
+        }
+    }
+
+    const int ItemTokens = 19;  //每条item记录的固定token数
+    const int PathTokens = 4;
+
+    //和旧实现一致 头token不管匹不匹配都消耗掉 缺头按零条处理
+    qsizetype cursor = 0;
+    quint32 itemCount = 0;
+    if (cursor < tokens.size()) {
+        if (tokens.at(cursor).startsWith(u"DT_Size_"))
+            itemCount = tokens.at(cursor).mid(8).toUInt();
+        ++cursor;
+    }
+    if (cursor + qsizetype(itemCount) * ItemTokens > tokens.size())
+        return false;   //记录数和实际token对不上 文件已损坏
+
+    //item记录按核数分块 {起始记录号,条数}
+    const int threadCount = qMax(1, QThread::idealThreadCount());
+    const quint32 chunkSize = qMax<quint32>(1, (itemCount + threadCount - 1) / threadCount);
+    QList<QPair<quint32, quint32>> chunks;
+    for (quint32 first = 0; first < itemCount; first += chunkSize)
+        chunks.append(qMakePair(first, qMin(chunkSize, itemCount - first)));
+
+    const qsizetype itemBase = cursor;
+    const auto parseChunk = [&tokens, itemBase, ItemTokens](const QPair<quint32, quint32> &chunk) {
+        QList<ReadDiagramItem> parsed;
+        parsed.reserve(chunk.second);
+        for (quint32 i = 0; i < chunk.second; ++i) {
+            const qsizetype at = itemBase + qsizetype(chunk.first + i) * ItemTokens;
+            ReadDiagramItem item;
+            item.x = tokens.at(at + 0).toInt();
+            item.y = tokens.at(at + 1).toInt();
+            item.width = tokens.at(at + 2).toInt();
+            item.height = tokens.at(at + 3).toInt();
+            item.type = tokens.at(at + 4).toInt();
+            for (int j = 0; j < 4; ++j)
+                item.rbg[j] = tokens.at(at + 5 + j).toInt();
+            //星号还原成空格 和串行版一致
+            item.internalText = tokens.at(at + 9).toString().replace("*", " ");
+            item.itemtype = tokens.at(at + 10).toInt();
+            item.texttype = tokens.at(at + 11).toString().replace("*", " ");
+            item.textsize = tokens.at(at + 12).toInt();
+            item.boldtype = tokens.at(at + 13) == u"true";
+            item.itlatic = tokens.at(at + 14) == u"true";
+            for (int j = 0; j < 4; ++j)
+                item.textrbg[j] = tokens.at(at + 15 + j).toInt();
+            parsed.append(item);
+        }
+        return parsed;
+    };
+    const QList<QList<ReadDiagramItem>> parsedChunks =
+        QtConcurrent::blockingMapped(chunks, parseChunk);
+    for (const QList<ReadDiagramItem> &part : parsedChunks)
+        readDiagramItems.append(part);
+    cursor += qsizetype(itemCount) * ItemTokens;
+
+    quint32 pathCount = 0;
+    if (cursor < tokens.size()) {
+        if (tokens.at(cursor).startsWith(u"LN_Size_"))
+            pathCount = tokens.at(cursor).mid(8).toUInt();
+        ++cursor;
+    }
+    if (cursor + qsizetype(pathCount) * PathTokens > tokens.size())
+        return false;
+    //端点编号是1起的item下标 锚位直接索引定长槽位数组 越界值不能放进场景重建
+    const auto validAnchor = [](int anchor) {
+        return anchor == DiagramItem::TF_Top || anchor == DiagramItem::TF_Right
+            || anchor == DiagramItem::TF_Bottom || anchor == DiagramItem::TF_Left;
+    };
+    readDiagramPaths.reserve(pathCount);
+    for (quint32 i = 0; i < pathCount; ++i) {
+        ReadDiagramPath path;
+        path.start = tokens.at(cursor + 0).toInt();
+        path.startp = tokens.at(cursor + 1).toInt();
+        path.end = tokens.at(cursor + 2).toInt();
+        path.endp = tokens.at(cursor + 3).toInt();
+        if (path.start < 1 || quint32(path.start) > itemCount
+                || path.end < 1 || quint32(path.end) > itemCount
+                || !validAnchor(path.startp) || !validAnchor(path.endp))
+            return false;   //连线记录指向不存在的item或非法锚位 文件已损坏
+        readDiagramPaths.append(path);
+        cursor += PathTokens;
+    }
+    return true;
+}
+
+//按读取记录批量重建场景 loadfile/快照回滚/无头导出共用
+void ProjectLoader::populateScene(DiagramScene *scene, QMenu *itemMenu,
+                                  const QList<ReadDiagramItem> &readDiagramItems,
+                                  const QList<ReadDiagramPath> &readDiagramPaths)
+{
+    PerfScope scope("loader.populateScene");
+    //批量导入模式 先把所有对象构造好 再一口气挂进场景 最后重建一次索引
+    scene->beginBulkLoad();
+
+    QList<DiagramItem*> DiagramItemList;
+    foreach (ReadDiagramItem item,readDiagramItems) {
+        DiagramItem *item1=new DiagramItem(static_cast<DiagramItem::DiagramType>(item.itemtype),itemMenu);
+        item1->setPos(QPoint(item.x,item.y));
+        item1->setFixedSize(QSize(item.width,item.height));
+        QColor itemcolor(item.rbg[0],item.rbg[2],item.rbg[1],item.rbg[3]);
+        QColor textcolor(item.textrbg[0],item.textrbg[2],item.textrbg[1],item.textrbg[3]);
+        item1->m_color=itemcolor;
+        //批量导入只写标签字符串和属性 不触发任何富文本排版
+        item1->setLabelText(item.internalText);
+        QFont labelFont = item1->labelFont();
+        labelFont.setPointSize(item.textsize);
+        labelFont.setFamily(item.texttype);
+        labelFont.setBold(item.boldtype);
+        labelFont.setItalic(item.itlatic);
+        item1->setLabelFont(labelFont);
+        item1->setLabelColor(textcolor);
+        DiagramItemList.append(item1);
+    }
+
+    int size = DiagramItemList.size();
+    qDebug()<<"size: "<< size;
+    QList<DiagramPath*> DiagramPathList;
+    foreach (ReadDiagramPath item,readDiagramPaths) {
+        DiagramItem *startItem = DiagramItemList.at(item.start-1 );
+        DiagramItem *endItem = DiagramItemList.at(item.end-1 );
+        DiagramItem::TransformState startState = static_cast<DiagramItem::TransformState>(item.startp);
+        DiagramItem::TransformState endState = static_cast<DiagramItem::TransformState>(item.endp);
+
+        DiagramPath *item1=new DiagramPath(startItem,endItem,startState,endState);
+
+        startItem->addLink(item1, true, quint8(startState));
+        endItem->addLink(item1, false, quint8(endState));
+        item1->updatePath();
+        item1->setZValue(-1000.0);
+        DiagramPathList.append(item1);
+    }
+
+    //统一挂进场景 索引和信号此时都是关的
+    foreach (DiagramItem *item1, DiagramItemList) {
+        scene->addItem(item1);
+    }
+    foreach (DiagramPath *item1, DiagramPathList) {
+        scene->addItem(item1);
+    }
+
+    scene->endBulkLoad();
+}
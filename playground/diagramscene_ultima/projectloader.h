@@ -0,0 +1,35 @@
+#ifndef PROJECTLOADER_H
+#define PROJECTLOADER_H
+
+#include <QString>
+#include <QList>
+#include "projectrecords.h"
+
+QT_BEGIN_NAMESPACE
+class QMenu;
+QT_END_NAMESPACE
+
+class DiagramScene;
+
+//工程文件读取与场景重建 GUI加载和无头批量导出共用
+//二进制.fcproj直接映射读取 旧文本格式走并行解析回退
+class ProjectLoader
+{
+public:
+    //按文件头自动选二进制/旧文本格式 失败返回false
+    static bool loadProject(const QString &fileName,
+                            QList<ReadDiagramItem> &readDiagramItems,
+                            QList<ReadDiagramPath> &readDiagramPaths);
+
+    //旧文本格式的并行解析 item记录互相独立 分块交给QtConcurrent
+    static bool parseLegacyProject(const QString &fileName,
+                                   QList<ReadDiagramItem> &readDiagramItems,
+                                   QList<ReadDiagramPath> &readDiagramPaths);
+
+    //按读取记录批量重建场景 itemMenu可为空(无头模式没有右键菜单)
+    static void populateScene(DiagramScene *scene, QMenu *itemMenu,
+                              const QList<ReadDiagramItem> &readDiagramItems,
+                              const QList<ReadDiagramPath> &readDiagramPaths);
+};
+
+#endif // PROJECTLOADER_H
@@ -0,0 +1,58 @@
+#ifndef PROJECTRECORDS_H
+#define PROJECTRECORDS_H
+
+#include <QString>
+
+//工程文件读写用的中间结构体 原来定义在mainwindow.cpp里
+//二进制格式读写也要用 所以挪到公共头文件
+
+// DiagramItem 和 LineSegment 结构体的定义
+struct  WriteDiagramItem {
+    int x; // x坐标
+    int y; // y坐标
+    int width; // 宽度
+    int height; // 高度
+    int type; // 图形类型
+    int rbg[4]; // 图形颜色(rbg三原色+透明度)
+    QString internalText; // 图形内部Text的内容
+    int itemtype;// 图形的类型
+    QString texttype;// 图形内部文本的类型
+    int textsize;//文字字号
+    bool boldtype;//是否黑体
+    bool itlatic;//是否斜体
+    int textrbg[4];// 图形内部文字的color
+};
+
+struct ReadDiagramItem {
+    int x; // x坐标
+    int y; // y坐标
+    int width; // 宽度
+    int height; // 高度
+    int type; // 图形类型
+    int rbg[4]; // 图形颜色(rbg三原色+透明度)
+    QString internalText; // 图形内部Text的内容
+    int itemtype;// 图形的类型
+    QString texttype;// 图形内部文本的类型
+    int textsize;//文字字号
+    bool boldtype;//是否黑体
+    bool itlatic;//是否斜体
+    int textrbg[4];// 图形内部文字的color
+};
+
+struct WriteDiagramPath
+{
+    int start;//开始item编号
+    int startp;//开始item节点
+    int end;//结束item编号
+    int endp;//结束item节点
+};
+
+struct ReadDiagramPath
+{
+    int start;//开始item编号
+    int startp;//开始item节点
+    int end;//结束item编号
+    int endp;//结束item节点
+};
+
+#endif // PROJECTRECORDS_H
@@ -0,0 +1,284 @@
+#include <QtTest/QtTest>
+#include <QApplication>
+#include <QGraphicsSceneMouseEvent>
+#include <QMenu>
+#include <QImage>
+#include <QPainter>
+#include <QUndoStack>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QFile>
+#include <QElapsedTimer>
+#include "../diagramscene.h"
+#include "../diagramitem.h"
+#include "../diagrampath.h"
+#include "../binaryprojectfile.h"
+#include "../projectrecords.h"
+#include "../editcommands.h"
+
+/**
+ * 场景规模基准测试
+ * 用合成场景量化热路径耗时：重绘/拖动/快照/加载/撤销重做
+ * 结果写到 bench_results.json；目录下有 bench_baseline.json 时逐项对比
+ * 超过基线 BENCH_TOLERANCE 倍(默认2.0)就让测试失败 让回归在PR里直接可见
+ *
+ * 规模用环境变量控制：BENCH_ITEMS(默认2000 上限100000)
+ */
+class DiagramBench : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void benchPopulate();
+    void benchRepaint();
+    void benchDrag();
+    void benchSnapshot();
+    void benchLoad();
+    void benchUndoRedo();
+    void cleanupTestCase();
+
+private:
+    //生成链状合成场景 item摆成网格 相邻两个用连线接起来
+    void buildRecords();
+    void populateInto(DiagramScene *targetScene,
+                      QList<DiagramItem *> &outItems, QList<DiagramPath *> &outPaths);
+    void record(const QString &name, qreal ms);
+
+    QMenu *itemMenu = nullptr;
+    DiagramScene *scene = nullptr;
+    QList<DiagramItem *> benchItems;
+    QList<DiagramPath *> benchPaths;
+    QList<WriteDiagramItem> writeItems;
+    QList<WriteDiagramPath> writePaths;
+    QByteArray snapshotBytes;
+    QJsonObject results;
+    int itemCount = 2000;
+};
+
+void DiagramBench::initTestCase()
+{
+    bool ok = false;
+    const int envItems = qEnvironmentVariableIntValue("BENCH_ITEMS", &ok);
+    if (ok && envItems > 0)
+        itemCount = qMin(envItems, 100000);
+    qDebug() << "=== 基准规模:" << itemCount << "个图元" << itemCount - 1 << "条连线 ===";
+
+    //和应用启动时一致 连线走聚合层批量绘制 repaint基准量到的就是这条路径
+    DiagramPath::setBatchedRendering(true);
+
+    itemMenu = new QMenu();
+    scene = new DiagramScene(itemMenu, this);
+    scene->setSceneRect(0, 0, 20000, 20000);
+}
+
+//按populateScene的方式把合成对象批量挂进场景
+void DiagramBench::populateInto(DiagramScene *targetScene,
+                                QList<DiagramItem *> &outItems, QList<DiagramPath *> &outPaths)
+{
+    targetScene->beginBulkLoad();
+    for (int i = 0; i < itemCount; ++i) {
+        DiagramItem *item = new DiagramItem(DiagramItem::Step, itemMenu);
+        item->setPos(QPointF((i % 100) * 200, (i / 100) * 150));
+        targetScene->addItem(item);
+        outItems.append(item);
+    }
+    for (int i = 0; i + 1 < itemCount; ++i) {
+        DiagramItem *startItem = outItems.at(i);
+        DiagramItem *endItem = outItems.at(i + 1);
+        DiagramPath *path = new DiagramPath(startItem, endItem,
+                                            DiagramItem::TF_Right, DiagramItem::TF_Left);
+        startItem->addLink(path, true, quint8(DiagramItem::TF_Right));
+        endItem->addLink(path, false, quint8(DiagramItem::TF_Left));
+        path->start = i + 1;
+        path->startp = DiagramItem::TF_Right;
+        path->end = i + 2;
+        path->endp = DiagramItem::TF_Left;
+        path->updatePath();
+        path->setZValue(-1000.0);
+        targetScene->addItem(path);
+        outPaths.append(path);
+    }
+    targetScene->endBulkLoad();
+}
+
+void DiagramBench::record(const QString &name, qreal ms)
+{
+    results[name] = ms;
+    qDebug() << name << ":" << ms << "ms";
+}
+
+void DiagramBench::benchPopulate()
+{
+    QElapsedTimer timer;
+    timer.start();
+    populateInto(scene, benchItems, benchPaths);
+    record("populate_ms", timer.nsecsElapsed() / 1e6);
+}
+
+void DiagramBench::benchRepaint()
+{
+    QImage canvas(1280, 960, QImage::Format_ARGB32_Premultiplied);
+    const QPointF center = scene->sceneRect().center();
+    //三档缩放 视口固定 源区域按倍率缩放
+    const struct { const char *name; qreal zoom; } levels[] = {
+        { "repaint_zoom025_ms", 0.25 },
+        { "repaint_zoom100_ms", 1.0 },
+        { "repaint_zoom400_ms", 4.0 },
+    };
+    for (const auto &level : levels) {
+        const qreal w = 1280 / level.zoom;
+        const qreal h = 960 / level.zoom;
+        const QRectF source(center.x() - w / 2, center.y() - h / 2, w, h);
+        canvas.fill(Qt::white);
+        QPainter painter(&canvas);
+        QElapsedTimer timer;
+        timer.start();
+        scene->render(&painter, QRectF(0, 0, 1280, 960), source);
+        record(level.name, timer.nsecsElapsed() / 1e6);
+    }
+}
+
+void DiagramBench::benchDrag()
+{
+    QVERIFY(!benchItems.isEmpty());
+    DiagramItem *target = benchItems.first();
+    const QPointF startPos = target->sceneBoundingRect().center();
+
+    QGraphicsSceneMouseEvent press(QEvent::GraphicsSceneMousePress);
+    press.setScenePos(startPos);
+    press.setButton(Qt::LeftButton);
+    press.setButtons(Qt::LeftButton);
+    QApplication::sendEvent(scene, &press);
+
+    //脚本化拖动 1000个move事件走完整的对齐+辅助线+重算路径
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 1; i <= 1000; ++i) {
+        QGraphicsSceneMouseEvent move(QEvent::GraphicsSceneMouseMove);
+        move.setScenePos(startPos + QPointF(i * 0.5, i * 0.3));
+        move.setButtons(Qt::LeftButton);
+        QApplication::sendEvent(scene, &move);
+    }
+    record("drag_1000_ms", timer.nsecsElapsed() / 1e6);
+
+    QGraphicsSceneMouseEvent release(QEvent::GraphicsSceneMouseRelease);
+    release.setScenePos(startPos + QPointF(500, 300));
+    release.setButton(Qt::LeftButton);
+    QApplication::sendEvent(scene, &release);
+}
+
+void DiagramBench::benchSnapshot()
+{
+    //对标savefilestack/performAutosave的遍历+序列化
+    QElapsedTimer timer;
+    timer.start();
+    buildRecords();
+    snapshotBytes = BinaryProjectFile::serialize(writeItems, writePaths);
+    record("snapshot_ms", timer.nsecsElapsed() / 1e6);
+    QVERIFY(!snapshotBytes.isEmpty());
+}
+
+void DiagramBench::buildRecords()
+{
+    writeItems.clear();
+    writePaths.clear();
+    for (DiagramItem *item : std::as_const(benchItems)) {
+        WriteDiagramItem record{};
+        record.x = int(item->pos().x());
+        record.y = int(item->pos().y());
+        record.width = int(item->getSize().width());
+        record.height = int(item->getSize().height());
+        record.itemtype = item->diagramType();
+        record.internalText = item->textContent;
+        record.textsize = 12;
+        writeItems.append(record);
+    }
+    for (DiagramPath *path : std::as_const(benchPaths)) {
+        WriteDiagramPath record{};
+        record.start = path->start;
+        record.startp = path->startp;
+        record.end = path->end;
+        record.endp = path->endp;
+        writePaths.append(record);
+    }
+}
+
+void DiagramBench::benchLoad()
+{
+    //对标loadfile：解析快照字节流+批量重建场景
+    QList<ReadDiagramItem> readItems;
+    QList<ReadDiagramPath> readPaths;
+    QElapsedTimer timer;
+    timer.start();
+    QVERIFY(BinaryProjectFile::deserialize(snapshotBytes, readItems, readPaths));
+    record("load_parse_ms", timer.nsecsElapsed() / 1e6);
+    QCOMPARE(readItems.size(), benchItems.size());
+    QCOMPARE(readPaths.size(), benchPaths.size());
+
+    DiagramScene loadScene(itemMenu);
+    loadScene.setSceneRect(scene->sceneRect());
+    QList<DiagramItem *> loadedItems;
+    QList<DiagramPath *> loadedPaths;
+    timer.restart();
+    populateInto(&loadScene, loadedItems, loadedPaths);
+    record("load_populate_ms", timer.nsecsElapsed() / 1e6);
+}
+
+void DiagramBench::benchUndoRedo()
+{
+    QUndoStack undoStack;
+    DiagramItem *target = benchItems.first();
+    const QPointF basePos = target->pos();
+    for (int i = 0; i < 1000; ++i) {
+        undoStack.push(new MoveItemCommand(target, basePos + QPointF(i, i),
+                                           basePos + QPointF(i + 1, i + 1)));
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    while (undoStack.canUndo())
+        undoStack.undo();
+    while (undoStack.canRedo())
+        undoStack.redo();
+    record("undoredo_1000_ms", timer.nsecsElapsed() / 1e6);
+}
+
+void DiagramBench::cleanupTestCase()
+{
+    //结果落盘 机器可读 供CI归档或更新基线
+    QJsonObject root;
+    root["items"] = itemCount;
+    root["paths"] = itemCount - 1;
+    root["scenarios"] = results;
+    QFile out("bench_results.json");
+    QVERIFY(out.open(QIODevice::WriteOnly));
+    out.write(QJsonDocument(root).toJson());
+    out.close();
+    qDebug() << "基准结果已写入" << QFileInfo(out).absoluteFilePath();
+
+    //有基线就逐项对比 超过容差倍数判失败
+    QFile baselineFile("bench_baseline.json");
+    if (!baselineFile.open(QIODevice::ReadOnly)) {
+        qDebug() << "没有bench_baseline.json 跳过基线对比";
+        return;
+    }
+    const QJsonObject baseline =
+        QJsonDocument::fromJson(baselineFile.readAll()).object()["scenarios"].toObject();
+    bool ok = false;
+    qreal tolerance = qEnvironmentVariable("BENCH_TOLERANCE").toDouble(&ok);
+    if (!ok || tolerance <= 0)
+        tolerance = 2.0;
+    for (auto it = baseline.begin(); it != baseline.end(); ++it) {
+        if (!results.contains(it.key()))
+            continue;
+        const qreal baseMs = it.value().toDouble();
+        const qreal nowMs = results[it.key()].toDouble();
+        const QString message = QString("%1: %2ms 超过基线 %3ms 的 %4 倍")
+                                    .arg(it.key()).arg(nowMs).arg(baseMs).arg(tolerance);
+        QVERIFY2(baseMs <= 0 || nowMs <= baseMs * tolerance, qPrintable(message));
+    }
+}
+
+QTEST_MAIN(DiagramBench)
+#include "bench_diagram.moc"
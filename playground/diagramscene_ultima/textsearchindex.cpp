@@ -0,0 +1,104 @@
+#include "textsearchindex.h"
+#include "diagramtextitem.h"
+
+void TextSearchIndex::clear()
+{
+    m_texts.clear();
+    m_trigrams.clear();
+}
+
+QSet<QString> TextSearchIndex::trigramsOf(const QString &text)
+{
+    //统一转小写 候选集按不区分大小写给 最终匹配再按原样验证
+    const QString lowered = text.toLower();
+    QSet<QString> result;
+    for (int i = 0; i + 3 <= lowered.size(); ++i)
+        result.insert(lowered.mid(i, 3));
+    return result;
+}
+
+void TextSearchIndex::updateItem(DiagramTextItem *item, const QString &text)
+{
+    auto it = m_texts.constFind(item);
+    if (it != m_texts.constEnd()) {
+        if (it.value() == text)
+            return;
+        //旧内容的倒排条目先摘掉
+        const QSet<QString> oldTrigrams = trigramsOf(it.value());
+        for (const QString &trigram : oldTrigrams) {
+            auto entry = m_trigrams.find(trigram);
+            if (entry != m_trigrams.end()) {
+                entry.value().remove(item);
+                if (entry.value().isEmpty())
+                    m_trigrams.erase(entry);
+            }
+        }
+    }
+
+    m_texts.insert(item, text);
+    const QSet<QString> newTrigrams = trigramsOf(text);
+    for (const QString &trigram : newTrigrams)
+        m_trigrams[trigram].insert(item);
+}
+
+void TextSearchIndex::removeItem(DiagramTextItem *item)
+{
+    auto it = m_texts.constFind(item);
+    if (it == m_texts.constEnd())
+        return;
+    const QSet<QString> trigrams = trigramsOf(it.value());
+    for (const QString &trigram : trigrams) {
+        auto entry = m_trigrams.find(trigram);
+        if (entry != m_trigrams.end()) {
+            entry.value().remove(item);
+            if (entry.value().isEmpty())
+                m_trigrams.erase(entry);
+        }
+    }
+    m_texts.remove(item);
+}
+
+QSet<DiagramTextItem *> TextSearchIndex::matches(const QString &needle,
+                                                 const QList<QGraphicsItem *> &sceneItems)
+{
+    //场景里还没进索引的项补一次 之后都是纯哈希查询
+    QSet<DiagramTextItem *> inScene;
+    for (QGraphicsItem *item : sceneItems) {
+        DiagramTextItem *textItem = qgraphicsitem_cast<DiagramTextItem *>(item);
+        if (textItem == nullptr)
+            continue;
+        inScene.insert(textItem);
+        if (!m_texts.contains(textItem))
+            updateItem(textItem, textItem->toPlainText());
+    }
+
+    QSet<DiagramTextItem *> result;
+    if (needle.size() >= 3) {
+        //三字组取交集筛候选 最后用缓存文本按原样验证
+        const QSet<QString> needleTrigrams = trigramsOf(needle);
+        QSet<DiagramTextItem *> candidates;
+        bool first = true;
+        for (const QString &trigram : needleTrigrams) {
+            const QSet<DiagramTextItem *> entry = m_trigrams.value(trigram);
+            if (first) {
+                candidates = entry;
+                first = false;
+            } else {
+                candidates.intersect(entry);
+            }
+            if (candidates.isEmpty())
+                return result;
+        }
+        for (DiagramTextItem *item : std::as_const(candidates)) {
+            if (inScene.contains(item) && m_texts.value(item).contains(needle))
+                result.insert(item);
+        }
+    } else {
+        //短查询没有三字组可用 扫一遍缓存文本 仍然不碰场景对象
+        for (DiagramTextItem *item : std::as_const(inScene)) {
+            if (m_texts.value(item).contains(needle))
+                result.insert(item);
+        }
+    }
+    return result;
+}
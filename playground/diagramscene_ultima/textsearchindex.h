@@ -0,0 +1,38 @@
+#ifndef TEXTSEARCHINDEX_H
+#define TEXTSEARCHINDEX_H
+
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QList>
+
+class QGraphicsItem;
+class DiagramTextItem;
+
+//查找替换用的全文索引
+//每个文本项的内容缓存一份 标签改动时增量更新
+//三字组(trigram)倒排表做候选筛选 查找时不再整场景toPlainText
+class TextSearchIndex
+{
+public:
+    void clear();
+
+    //标签内容变了 换掉缓存和对应的倒排表条目
+    void updateItem(DiagramTextItem *item, const QString &text);
+    void removeItem(DiagramTextItem *item);
+
+    //返回内容包含needle的文本项 没见过的项第一次会补进索引
+    QSet<DiagramTextItem *> matches(const QString &needle,
+                                    const QList<QGraphicsItem *> &sceneItems);
+
+    //缓存的文本内容 查找定位用 避免再次toPlainText
+    QString textOf(DiagramTextItem *item) const { return m_texts.value(item); }
+
+private:
+    static QSet<QString> trigramsOf(const QString &text);
+
+    QHash<DiagramTextItem *, QString> m_texts;          //每项的内容缓存
+    QHash<QString, QSet<DiagramTextItem *>> m_trigrams; //小写三字组 -> 含有它的项
+};
+
+#endif // TEXTSEARCHINDEX_H